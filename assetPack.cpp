@@ -0,0 +1,88 @@
+#include "assetPack.h"
+
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+
+/// <summary>
+/// Maps a pack and checks its index. A missing or damaged pack leaves every asset to the loose files.
+/// </summary>
+/// <param name="packPath">Pack file to map</param>
+/// <param name="_looseRoot">Directory the asset names are relative to, ending in a slash</param>
+AssetPack::AssetPack(const string& packPath, const string& _looseRoot) : file(packPath) {
+	looseRoot = _looseRoot;
+	if (!file.isOpen()) return;
+
+	PackHeader header;
+	bool valid = file.size() >= sizeof(header);
+	if (valid) {
+		memcpy(&header, file.data(), sizeof(header));
+		uint64_t indexEnd = sizeof(header) + (uint64_t)header.entryCount * sizeof(PackEntry);
+		valid = header.magic == packMagic && indexEnd <= header.namesOffset && header.namesOffset <= file.size() &&
+			header.namesSize <= file.size() - header.namesOffset;
+	}
+	//Every name and every asset has to lie inside the file, so views never run past the mapping
+	const PackEntry* index = valid ? (const PackEntry*)(file.data() + sizeof(header)) : nullptr;
+	for (uint32_t i = 0; valid && i < header.entryCount; i++) {
+		const PackEntry& entry = index[i];
+		valid = (uint64_t)entry.nameOffset + entry.nameLength <= header.namesSize && entry.offset <= file.size() &&
+			entry.size <= file.size() - entry.offset;
+	}
+	if (!valid) {
+		cout << "Asset pack " << packPath << " is damaged, loading loose files instead" << endl;
+		file.close();
+		return;
+	}
+
+	entries = index;
+	entryCount = header.entryCount;
+	names = (const char*)file.data() + header.namesOffset;
+}
+
+/// <summary>
+/// Binary search of the index, the packer sorts it by name
+/// </summary>
+/// <param name="name">Asset name</param>
+/// <returns>The entry, null if the pack does not have it</returns>
+const PackEntry* AssetPack::find(const string& name) const {
+	uint32_t low = 0, high = entryCount;
+	while (low < high) {
+		uint32_t middle = (low + high) / 2;
+		const PackEntry& entry = entries[middle];
+		int order = memcmp(names + entry.nameOffset, name.data(), min((size_t)entry.nameLength, name.size()));
+		if (order == 0) order = entry.nameLength < name.size() ? -1 : entry.nameLength > name.size() ? 1 : 0;
+		if (order == 0) return &entry;
+		if (order < 0) low = middle + 1;
+		else high = middle;
+	}
+	return nullptr;
+}
+
+/// <summary>
+/// An asset from the pack, or its loose file when the pack does not have it
+/// </summary>
+/// <param name="name">Path relative to the project root, e.g. shaders/7.1.camera.vs</param>
+/// <returns>The bytes, closed if the asset exists nowhere</returns>
+Asset AssetPack::open(const string& name) const {
+	const PackEntry* entry = find(name);
+	if (!entry) return openFile(loosePath(name));
+
+	Asset asset;
+	asset.data = file.data() + entry->offset;
+	asset.size = (size_t)entry->size;
+	asset.entry = entry;
+	return asset;
+}
+
+/// <summary>
+/// Maps a loose file as an asset
+/// </summary>
+/// <param name="path">File to map</param>
+/// <returns>The bytes, closed if the file is missing or empty</returns>
+Asset AssetPack::openFile(const string& path) {
+	Asset asset;
+	asset.loose = make_shared<MappedFile>(path);
+	asset.data = asset.loose->data();
+	asset.size = asset.loose->size();
+	return asset;
+}
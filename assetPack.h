@@ -0,0 +1,90 @@
+#ifndef AssetPack_header
+#define AssetPack_header
+
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <streambuf>
+#include "mappedFile.h"
+#include "fnvHash.h"
+
+using namespace std;
+
+//Layout of an asset pack (.pak): the header, the index sorted by name, the names, then the bytes of
+//every asset, each starting on a 16 byte boundary. Names are paths relative to the project root.
+const uint32_t packMagic = 0x314B4150; // "PAK1"
+const uint64_t packAlignment = 16;
+struct PackHeader
+{
+	uint32_t magic;
+	uint32_t entryCount;
+	uint64_t namesOffset;   // from the start of the file
+	uint64_t namesSize;
+};
+struct PackEntry
+{
+	uint32_t nameOffset;    // into the names
+	uint32_t nameLength;
+	uint64_t offset;        // from the start of the file
+	uint64_t size;
+	uint64_t hash;          // hashBytes of the bytes
+};
+
+//Bytes of one asset, a view into the pack or a loose file mapped on its own
+struct Asset
+{
+	const unsigned char* data = nullptr;
+	size_t size = 0;
+	shared_ptr<MappedFile> loose;   // keeps a loose file mapped, views into the pack need nothing
+	const PackEntry* entry = nullptr;   // index entry of an asset from the pack
+
+	bool isOpen() const { return data != nullptr; }
+
+	/// <summary>
+	/// hashBytes of the asset, taken from the pack index when it comes from the pack
+	/// </summary>
+	uint64_t getHash() const { return entry ? entry->hash : hashBytes(data, size); }
+};
+
+//Lets stream based parsers read an asset in place
+class AssetStreamBuffer : public streambuf {
+public:
+	AssetStreamBuffer(const Asset& asset) {
+		char* begin = (char*)asset.data;
+		setg(begin, begin, begin + asset.size);
+	}
+};
+
+/// <summary>
+/// The game's shaders, textures, models and levels, read from one mapped pack file.
+/// Assets missing from the pack, or every asset when there is no pack, are mapped
+/// as loose files below the project root instead, so edits show up without repacking.
+/// </summary>
+class AssetPack {
+private:
+	MappedFile file;
+	const PackEntry* entries = nullptr;
+	const char* names = nullptr;
+	uint32_t entryCount = 0;
+	string looseRoot;
+
+	const PackEntry* find(const string& name) const;
+
+public:
+	AssetPack(const string& packPath, const string& _looseRoot);
+	AssetPack(const AssetPack&) = delete;
+	AssetPack& operator=(const AssetPack&) = delete;
+
+	Asset open(const string& name) const;
+	static Asset openFile(const string& path);
+
+	string loosePath(const string& name) const { return looseRoot + name; }
+	bool isPacked() const { return entries != nullptr; }
+	uint32_t getEntryCount() const { return entryCount; }
+	const PackEntry* getEntries() const { return entries; }
+	string getName(const PackEntry& entry) const { return string(names + entry.nameOffset, entry.nameLength); }
+	const unsigned char* getData(const PackEntry& entry) const { return file.data() + entry.offset; }
+};
+
+
+#endif
@@ -0,0 +1,975 @@
+//Benchmarks for the game simulation. Runs without window or GL context.
+//Usage: PacMan3DBench [benchmark name ...], runs all benchmarks if none are given
+
+//Standard libraries
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+//Custom classes etc
+#include "levelGrid.h"
+#include "ghost.h"
+#include "jobSystem.h"
+#include "flowField.h"
+#include "wallMesh.h"
+#include "chunkCulling.h"
+#include "visibilitySet.h"
+#include "indexedMesh.h"
+#include "meshSimplifier.h"
+#include "meshCache.h"
+#include "mappedFile.h"
+#include "levelFile.h"
+#include "glm/glm/gtc/matrix_transform.hpp"
+
+//Tiny object loader, to compare against parsing obj files
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "tinyobjloader/tiny_obj_loader.h"
+
+using namespace std;
+
+//Sink for benchmark results so the compiler can not drop the work
+volatile long long benchSink = 0;
+
+/// <summary>
+/// Seconds since an arbitrary point, for timing
+/// </summary>
+double now() {
+	return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// <summary>
+/// Generates a maze with loops, similar in layout to the pacman maps.
+/// Corridors are one tile wide and the border is solid.
+/// </summary>
+/// <param name="sizeX">Number of rows</param>
+/// <param name="sizeZ">Number of columns</param>
+/// <param name="seed">Seed for the layout</param>
+/// <returns>Generated level</returns>
+LevelGrid generateMaze(int sizeX, int sizeZ, unsigned int seed) {
+	LevelGrid grid(sizeX, sizeZ);
+	for (int x = 0; x < sizeX; x++) {
+		for (int z = 0; z < sizeZ; z++) {
+			grid.setWall(x, z, true);
+		}
+	}
+
+	//Depth first carving between cells on odd coordinates
+	mt19937 rng(seed);
+	int cellsX = (sizeX - 1) / 2, cellsZ = (sizeZ - 1) / 2;
+	vector<bool> visited((size_t)cellsX * cellsZ, false);
+	vector<int> stack;
+	stack.push_back(0);
+	visited[0] = true;
+	grid.setWall(1, 1, false);
+
+	const int dx[4] = { 1, -1, 0, 0 };
+	const int dz[4] = { 0, 0, 1, -1 };
+	while (!stack.empty()) {
+		int cell = stack.back();
+		int cx = cell / cellsZ, cz = cell % cellsZ;
+
+		int options[4], count = 0;
+		for (int d = 0; d < 4; d++) {
+			int nx = cx + dx[d], nz = cz + dz[d];
+			if (nx >= 0 && nz >= 0 && nx < cellsX && nz < cellsZ && !visited[(size_t)nx * cellsZ + nz]) {
+				options[count++] = d;
+			}
+		}
+		if (count == 0) {
+			stack.pop_back();
+			continue;
+		}
+
+		int d = options[rng() % count];
+		int nx = cx + dx[d], nz = cz + dz[d];
+		visited[(size_t)nx * cellsZ + nz] = true;
+		grid.setWall(2 * cx + 1 + dx[d], 2 * cz + 1 + dz[d], false);
+		grid.setWall(2 * nx + 1, 2 * nz + 1, false);
+		stack.push_back(nx * cellsZ + nz);
+	}
+
+	//Knock out some walls between corridors so the maze has loops like the real maps
+	for (int x = 1; x < sizeX - 1; x++) {
+		for (int z = 1; z < sizeZ - 1; z++) {
+			bool betweenX = !grid.isWall(x - 1, z) && !grid.isWall(x + 1, z) && grid.isWall(x, z - 1) && grid.isWall(x, z + 1);
+			bool betweenZ = !grid.isWall(x, z - 1) && !grid.isWall(x, z + 1) && grid.isWall(x - 1, z) && grid.isWall(x + 1, z);
+			if (grid.isWall(x, z) && (betweenX || betweenZ) && rng() % 10 == 0) {
+				grid.setWall(x, z, false);
+			}
+		}
+	}
+	return grid;
+}
+
+/// <summary>
+/// Copies the walls of level tiles into a grid
+/// </summary>
+/// <param name="level">Tiles of the level</param>
+/// <param name="grid">Receives the walls</param>
+void fillLevelGrid(const LevelTiles& level, LevelGrid& grid) {
+	grid = LevelGrid(level.rows, level.columns);
+	for (int x = 0; x < level.rows; x++) {
+		for (int z = 0; z < level.columns; z++) {
+			grid.setWall(x, z, level.at(x, z) == levelWall);
+		}
+	}
+}
+
+/// <summary>
+/// Reads the walls of a level file in either format, see README
+/// </summary>
+/// <param name="path">Path to level file</param>
+/// <param name="grid">Receives the level</param>
+/// <returns>false if the file could not be read</returns>
+bool readLevelFile(const string& path, LevelGrid& grid) {
+	MappedFile file(path);
+	LevelTiles level;
+	if (!readLevelTiles(file.data(), file.size(), level)) return false;
+	fillLevelGrid(level, grid);
+	return true;
+}
+
+/// <summary>
+/// Reads the walls of a text level one stream token at a time, how levels were loaded before the
+/// binary format. Only used to compare against.
+/// </summary>
+/// <param name="path">Path to level file</param>
+/// <param name="grid">Receives the level</param>
+/// <returns>false if the file could not be read</returns>
+bool readLevelStream(const string& path, LevelGrid& grid) {
+	ifstream lvlFile(path);
+	string size;
+	if (!(lvlFile >> size) || size.find('x') == string::npos) return false;
+
+	int columns = stoi(size.substr(0, size.find('x')));
+	int rows = stoi(size.substr(size.find('x') + 1));
+	grid = LevelGrid(rows, columns);
+	int data;
+	for (int x = 0; x < rows; x++) {
+		for (int z = 0; z < columns; z++) {
+			if (!(lvlFile >> data)) return false;
+			grid.setWall(x, z, data == 1);
+		}
+	}
+	return true;
+}
+
+/// <summary>
+/// Collision queries against the tile grid compared to a scan over every wall segment.
+/// The grid cost should stay flat while the scan grows with the wall count.
+/// </summary>
+void benchCollision() {
+	cout << "== collision ==" << endl;
+	cout << setw(10) << "size" << setw(12) << "walls" << setw(16) << "scan ns/query" << setw(16) << "grid ns/query" << endl;
+
+	const int sizes[] = { 33, 129, 513, 2049 };
+	const float size = 0.75f;
+	for (int n : sizes) {
+		LevelGrid grid = generateMaze(n, n, 1);
+
+		vector<glm::vec3> walls;
+		vector<glm::vec3> open;
+		for (int x = 0; x < n; x++) {
+			for (int z = 0; z < n; z++) {
+				if (grid.isWall(x, z)) walls.push_back(glm::vec3(x, 0, z));
+				else open.push_back(glm::vec3(x, 0, z));
+			}
+		}
+
+		//Positions around walkable tiles, some of them touching walls
+		mt19937 rng(2);
+		uniform_real_distribution<float> jitter(-0.4f, 0.4f);
+		vector<glm::vec3> queries(100000);
+		for (auto& q : queries) {
+			q = open[rng() % open.size()] + glm::vec3(jitter(rng), 0, jitter(rng));
+		}
+
+		//The scan is linear in the wall count, so it gets fewer queries on big maps
+		size_t scanQueries = min(queries.size(), max((size_t)20, (size_t)200000000 / walls.size()));
+		double start = now();
+		long long hits = 0;
+		for (size_t i = 0; i < scanQueries; i++) {
+			glm::vec3 pos = queries[i];
+			for (const glm::vec3& wall : walls) {
+				bool xColl = wall.x + size >= pos.x && wall.x - size <= pos.x;
+				bool zColl = wall.z + size >= pos.z && wall.z - size <= pos.z;
+				if (xColl && zColl) { hits++; break; }
+			}
+		}
+		double scanTime = (now() - start) / scanQueries;
+
+		start = now();
+		long long gridHits = 0, gridHitsScanned = 0;
+		for (size_t i = 0; i < queries.size(); i++) {
+			bool hit = grid.overlapsWall(queries[i], size);
+			gridHits += hit;
+			if (i < scanQueries) gridHitsScanned += hit;
+		}
+		double gridTime = (now() - start) / queries.size();
+		benchSink += hits + gridHits;
+
+		cout << setw(10) << (to_string(n) + "x" + to_string(n)) << setw(12) << walls.size()
+			<< setw(16) << fixed << setprecision(1) << scanTime * 1e9 << setw(16) << gridTime * 1e9;
+		if (gridHitsScanned != hits) cout << "  MISMATCH (" << hits << " vs " << gridHitsScanned << ")";
+		cout << endl;
+	}
+}
+
+/// <summary>
+/// Spawns ghosts on random walkable tiles of a level
+/// </summary>
+/// <param name="grid">Level to spawn on</param>
+/// <param name="graph">Junction graph of the level</param>
+/// <param name="count">Number of ghosts</param>
+/// <param name="flow">If given, every ghost chases its target</param>
+/// <returns>Ghosts ready to update</returns>
+GhostSystem spawnGhosts(const LevelGrid& grid, const JunctionGraph& graph, int count, const FlowField* flow = nullptr) {
+	vector<int> open;
+	for (int x = 0; x < grid.getSizeX(); x++) {
+		for (int z = 0; z < grid.getSizeZ(); z++) {
+			if (!grid.isWall(x, z)) open.push_back(x * grid.getSizeZ() + z);
+		}
+	}
+
+	Pcg32 rng(3, 0);
+	GhostSystem ghosts(grid.view(), &graph, flow);
+	for (int i = 0; i < count; i++) {
+		int tile = open[rng.nextBounded((uint32_t)open.size())];
+		ghosts.addGhost(tile / grid.getSizeZ(), tile % grid.getSizeZ(), Pcg32(3, i + 1), flow != nullptr);
+	}
+	return ghosts;
+}
+
+/// <summary>
+/// Junction graph size and build time. Ghosts only make decisions at nodes,
+/// so tiles per corridor is how much per tile work the graph saves.
+/// </summary>
+void benchJunctions() {
+	cout << "== junctions ==" << endl;
+	cout << setw(10) << "size" << setw(12) << "walkable" << setw(10) << "nodes" << setw(12) << "corridors"
+		<< setw(14) << "tiles/corr" << setw(12) << "build ms" << endl;
+
+	const int sizes[] = { 33, 129, 513, 2049 };
+	for (int n : sizes) {
+		LevelGrid grid = generateMaze(n, n, 1);
+		long long walkable = 0;
+		for (int x = 0; x < n; x++) {
+			for (int z = 0; z < n; z++) walkable += !grid.isWall(x, z);
+		}
+
+		double start = now();
+		JunctionGraph graph(grid.view());
+		double elapsed = now() - start;
+
+		long long steps = 0;
+		for (int c = 0; c < graph.corridorCount(); c++) steps += graph.getCorridor(c).length;
+		cout << setw(10) << (to_string(n) + "x" + to_string(n)) << setw(12) << walkable << setw(10) << graph.nodeCount()
+			<< setw(12) << graph.corridorCount() << setw(14) << fixed << setprecision(2) << (double)steps / max(1, graph.corridorCount())
+			<< setw(12) << elapsed * 1000 << endl;
+	}
+}
+
+/// <summary>
+/// Wall geometry as separate segments compared to the baked mesh, once with only the
+/// hidden faces removed and once with the remaining faces merged, on level0 and a generated maze
+/// </summary>
+void benchWalls() {
+	cout << "== walls ==" << endl;
+	cout << setw(10) << "level" << setw(10) << "walls" << setw(16) << "segment tris" << setw(16) << "segment draws"
+		<< setw(14) << "culled tris" << setw(14) << "merged tris" << setw(14) << "baked draws" << setw(12) << "build ms" << endl;
+
+	struct Level { string name; LevelGrid grid; };
+	vector<Level> levels;
+	LevelGrid level0;
+	if (readLevelFile("../../../levels/level0", level0)) levels.push_back({ "level0", level0 });
+	else cout << "(level0 not found, run from the build directory)" << endl;
+	levels.push_back({ "512x512", generateMaze(512, 512, 1) });
+
+	for (const Level& level : levels) {
+		long long wallCount = 0;
+		for (int x = 0; x < level.grid.getSizeX(); x++) {
+			for (int z = 0; z < level.grid.getSizeZ(); z++) wallCount += level.grid.isWall(x, z);
+		}
+
+		double start = now();
+		WallMesh mesh(level.grid.view());
+		double elapsed = now() - start;
+
+		//A segment is four sides of two triangles, drawn with one call each before instancing
+		cout << setw(10) << level.name << setw(10) << wallCount << setw(16) << wallCount * 8 << setw(16) << wallCount
+			<< setw(14) << mesh.getFaceCount() * 2 << setw(14) << mesh.getTriangleCount() << setw(14) << 1 << setw(12) << fixed << setprecision(2) << elapsed * 1000 << endl;
+	}
+}
+
+/// <summary>
+/// Share of chunks and wall triangles left after frustum culling, for first person cameras
+/// standing in random corridors and looking in random directions, and the time the test takes.
+/// Also the time to find the pellets in visible chunks by testing every pellet and from per chunk buckets.
+/// </summary>
+void benchCulling() {
+	cout << "== culling ==" << endl;
+	cout << setw(10) << "size" << setw(10) << "chunks" << setw(16) << "visible chunks" << setw(16) << "visible tris"
+		<< setw(14) << "cull us" << setw(14) << "scan us" << setw(14) << "buckets us" << endl;
+
+	const glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1920.0f / 1080.0f, 0.1f, 100.0f);
+	const int sizes[] = { 33, 129, 513, 2049 };
+	for (int n : sizes) {
+		LevelGrid grid = generateMaze(n, n, 1);
+		WallMesh mesh(grid.view());
+		ChunkCulling culling(n, n, mesh.getChunkSize(), -2.0f, 2.0f);
+
+		vector<glm::vec3> open;
+		for (int x = 0; x < n; x++) {
+			for (int z = 0; z < n; z++) {
+				if (!grid.isWall(x, z)) open.push_back(glm::vec3(x, 0, z));
+			}
+		}
+
+		//A pellet on every open tile, collected by testing each one or from the buckets of the visible chunks
+		ChunkBuckets buckets(n, n, mesh.getChunkSize());
+		for (size_t p = 0; p < open.size(); p++) buckets.place((uint32_t)p, open[p]);
+		vector<glm::vec3> scanned;
+		vector<uint32_t> collected;
+
+		mt19937 rng(4);
+		const int views = 1000;
+		long long chunks = 0, vertices = 0;
+		double cullTime = 0, scanTime = 0, bucketTime = 0;
+		for (int i = 0; i < views; i++) {
+			glm::vec3 eye = open[rng() % open.size()];
+			float yaw = (float)(rng() % 360);
+			glm::vec3 front(cos(glm::radians(yaw)), 0.0f, sin(glm::radians(yaw)));
+			glm::mat4 view = glm::lookAt(eye, eye + front, glm::vec3(0, 1, 0));
+
+			double start = now();
+			culling.update(Frustum(projection * view));
+			cullTime += now() - start;
+
+			start = now();
+			scanned.clear();
+			for (const glm::vec3& pos : open) {
+				if (culling.isVisible(pos)) scanned.push_back(pos);
+			}
+			scanTime += now() - start;
+			start = now();
+			buckets.collect(culling.getVisibleChunks(), collected);
+			bucketTime += now() - start;
+			benchSink += (long long)(scanned.size() - collected.size());
+
+			chunks += culling.getVisibleCount();
+			for (int c = 0; c < culling.getChunkCount(); c++) {
+				if (culling.isVisible(c)) vertices += mesh.getChunkVertexCount(c);
+			}
+		}
+
+		cout << setw(10) << (to_string(n) + "x" + to_string(n)) << setw(10) << culling.getChunkCount()
+			<< setw(15) << fixed << setprecision(1) << 100.0 * chunks / ((double)views * culling.getChunkCount()) << "%"
+			<< setw(15) << 100.0 * vertices / ((double)views * max(1, mesh.getVertexCount())) << "%"
+			<< setw(14) << setprecision(2) << cullTime / views * 1e6 << setw(14) << scanTime / views * 1e6 << setw(14) << bucketTime / views * 1e6 << endl;
+	}
+}
+
+/// <summary>
+/// Chunks a fan of 4096 rays from each point of a 7x7 grid spread over the whole tile reaches, the wall
+/// that stops a ray included. A brute force reference to check the visibility sets against, sampled on
+/// its own so it also covers the camera standing near the edge of its tile.
+/// </summary>
+/// <param name="level">Level to cast in</param>
+/// <param name="chunkSize">Tiles along each side of a chunk</param>
+/// <param name="maxDistance">Rays stop after this many tiles</param>
+/// <param name="x">x tile to cast from</param>
+/// <param name="z">z tile to cast from</param>
+/// <param name="out">Receives the chunks, sorted</param>
+void referenceVisibleChunks(LevelView level, int chunkSize, float maxDistance, int x, int z, vector<uint32_t>& out) {
+	const int rays = 4096, grid = 7;
+	int chunksZ = (level.sizeZ + chunkSize - 1) / chunkSize;
+	out.clear();
+	for (int sample = 0; sample < grid * grid; sample++) {
+		//Tile t covers t - 0.5 to t + 0.5, the outer points stay just inside it
+		double ox = x - 0.499 + 0.998 * (sample / grid) / (grid - 1) + 0.5;
+		double oz = z - 0.499 + 0.998 * (sample % grid) / (grid - 1) + 0.5;
+		for (int r = 0; r < rays; r++) {
+			double angle = 6.283185307179586 * (r + 0.5) / rays;
+			double dx = cos(angle), dz = sin(angle);
+			double deltaX = fabs(1.0 / dx), deltaZ = fabs(1.0 / dz);
+			int tx = (int)floor(ox), tz = (int)floor(oz);
+			double nextX = (dx > 0 ? tx + 1 - ox : ox - tx) * deltaX;
+			double nextZ = (dz > 0 ? tz + 1 - oz : oz - tz) * deltaZ;
+			while (tx >= 0 && tz >= 0 && tx < level.sizeX && tz < level.sizeZ) {
+				out.push_back((uint32_t)((tx / chunkSize) * chunksZ + tz / chunkSize));
+				if (!level.isOpen(tx, tz)) break;
+				if (nextX < nextZ) {
+					if (nextX > maxDistance) break;
+					tx += dx > 0 ? 1 : -1;
+					nextX += deltaX;
+				}
+				else {
+					if (nextZ > maxDistance) break;
+					tz += dz > 0 ? 1 : -1;
+					nextZ += deltaZ;
+				}
+			}
+		}
+	}
+	sort(out.begin(), out.end());
+	out.erase(unique(out.begin(), out.end()), out.end());
+}
+
+/// <summary>
+/// Checks that every chunk the reference reaches from a tile is in its visibility set
+/// </summary>
+/// <param name="grid">Level the sets were built for</param>
+/// <param name="pvs">Sets to check</param>
+/// <param name="chunkSize">Tiles along each side of a chunk</param>
+/// <param name="maxDistance">View distance the sets were built for</param>
+/// <param name="samples">Walkable tiles to check, picked at random, all of them if the level has fewer</param>
+/// <returns>"yes" or "NO" with the number of tiles missing chunks</returns>
+string checkConservative(const LevelGrid& grid, const VisibilitySet& pvs, int chunkSize, float maxDistance, int samples) {
+	vector<int> open;
+	for (int x = 0; x < grid.getSizeX(); x++) {
+		for (int z = 0; z < grid.getSizeZ(); z++) {
+			if (!grid.isWall(x, z)) open.push_back(x * grid.getSizeZ() + z);
+		}
+	}
+	mt19937 rng(5);
+	shuffle(open.begin(), open.end(), rng);
+	open.resize(min((int)open.size(), samples));
+
+	int missedTiles = 0;
+	vector<uint32_t> reference;
+	for (int tile : open) {
+		int x = tile / grid.getSizeZ(), z = tile % grid.getSizeZ();
+		referenceVisibleChunks(grid.view(), chunkSize, maxDistance, x, z, reference);
+		int count;
+		const uint32_t* chunks = pvs.getChunks(x, z, count);
+		if (!includes(chunks, chunks + count, reference.begin(), reference.end())) missedTiles++;
+	}
+	return string(missedTiles == 0 ? "yes" : "NO") + " (" + to_string(missedTiles) + " of " + to_string(open.size()) + " tiles miss chunks)";
+}
+
+/// <summary>
+/// Potentially visible sets of generated mazes: build time, size, and the chunks and wall
+/// triangles left when they are combined with frustum culling, for random first person views.
+/// The sets of the mazes and of open fields with scattered walls are checked against a brute force reference.
+/// </summary>
+void benchPvs() {
+	cout << "== pvs ==" << endl;
+	cout << setw(10) << "size" << setw(12) << "build ms" << setw(10) << "sets" << setw(10) << "KB"
+		<< setw(16) << "frustum chunks" << setw(14) << "+pvs chunks" << setw(14) << "frustum tris" << setw(12) << "+pvs tris"
+		<< setw(14) << "cull us" << setw(14) << "conservative" << endl;
+
+	const glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1920.0f / 1080.0f, 0.1f, 100.0f);
+	JobSystem jobs(max(1, (int)thread::hardware_concurrency()));
+	const int sizes[] = { 33, 129, 513 };
+	for (int n : sizes) {
+		LevelGrid grid = generateMaze(n, n, 1);
+		WallMesh mesh(grid.view());
+		ChunkCulling culling(n, n, mesh.getChunkSize(), -2.0f, 2.0f);
+
+		double start = now();
+		VisibilitySet pvs(grid.view(), mesh.getChunkSize(), 100.0f, &jobs);
+		double buildTime = now() - start;
+
+		//Every chunk the reference reaches has to be in the sets as well, checked on a sample of the tiles
+		string conservative = checkConservative(grid, pvs, mesh.getChunkSize(), 100.0f, 200);
+
+		vector<glm::vec3> open;
+		for (int x = 0; x < n; x++) {
+			for (int z = 0; z < n; z++) {
+				if (!grid.isWall(x, z)) open.push_back(glm::vec3(x, 0, z));
+			}
+		}
+
+		mt19937 rng(4);
+		const int views = 1000;
+		long long frustumChunks = 0, pvsChunks = 0, frustumTris = 0, pvsTris = 0;
+		double cullTime = 0;
+		for (int i = 0; i < views; i++) {
+			glm::vec3 eye = open[rng() % open.size()];
+			float yaw = (float)(rng() % 360);
+			glm::vec3 front(cos(glm::radians(yaw)), 0.0f, sin(glm::radians(yaw)));
+			Frustum frustum(projection * glm::lookAt(eye, eye + front, glm::vec3(0, 1, 0)));
+
+			culling.update(frustum);
+			frustumChunks += culling.getVisibleCount();
+			for (int c : culling.getVisibleChunks()) frustumTris += mesh.getChunkVertexCount(c) / 3;
+
+			start = now();
+			int count;
+			const uint32_t* chunks = pvs.getChunks((int)eye.x, (int)eye.z, count);
+			culling.update(frustum, chunks, count);
+			cullTime += now() - start;
+			pvsChunks += culling.getVisibleCount();
+			for (int c : culling.getVisibleChunks()) pvsTris += mesh.getChunkVertexCount(c) / 3;
+		}
+
+		cout << setw(10) << (to_string(n) + "x" + to_string(n)) << setw(12) << fixed << setprecision(1) << buildTime * 1000
+			<< setw(10) << pvs.getSetCount() << setw(10) << pvs.getMemoryUsage() / 1024
+			<< setw(16) << (double)frustumChunks / views << setw(14) << (double)pvsChunks / views
+			<< setw(14) << frustumTris / views << setw(12) << pvsTris / views
+			<< setw(14) << setprecision(2) << cullTime / views * 1e6
+			<< "  " << conservative << endl;
+	}
+
+	//Open fields with scattered walls see far and through many gaps, the hardest case to stay conservative in
+	cout << setw(10) << "walls" << setw(12) << "build ms" << setw(10) << "sets" << setw(14) << "conservative" << endl;
+	const int densities[] = { 5, 15, 30 };
+	for (int density : densities) {
+		const int n = 161;
+		LevelGrid grid(n, n);
+		mt19937 rng(density);
+		for (int x = 0; x < n; x++) {
+			for (int z = 0; z < n; z++) {
+				grid.setWall(x, z, x == 0 || z == 0 || x == n - 1 || z == n - 1 || (int)(rng() % 100) < density);
+			}
+		}
+		double start = now();
+		VisibilitySet pvs(grid.view(), 16, 100.0f, &jobs);
+		double buildTime = now() - start;
+		cout << setw(9) << density << "%" << setw(12) << fixed << setprecision(1) << buildTime * 1000 << setw(10) << pvs.getSetCount()
+			<< "  " << checkConservative(grid, pvs, 16, 100.0f, 100) << endl;
+	}
+}
+
+/// <summary>
+/// Latitude longitude sphere laid out like an OBJ file: positions, normals and texture coordinates
+/// in separate lists and faces given as corners indexing them, triangles listed row by row
+/// </summary>
+/// <param name="rings">Rings from pole to pole</param>
+/// <param name="segments">Segments around</param>
+/// <param name="positions">Receives 3 floats per position</param>
+/// <param name="normals">Receives 3 floats per normal</param>
+/// <param name="texcoords">Receives 2 floats per texture coordinate</param>
+/// <returns>Corners of all triangles</returns>
+vector<MeshCorner> generateSphere(int rings, int segments, vector<float>& positions, vector<float>& normals, vector<float>& texcoords) {
+	const float pi = 3.14159265f;
+	for (int r = 0; r <= rings; r++) {
+		for (int s = 0; s < segments; s++) {
+			float theta = pi * r / rings, phi = 2 * pi * s / segments;
+			glm::vec3 p(sin(theta) * cos(phi), cos(theta), sin(theta) * sin(phi));
+			positions.insert(positions.end(), { p.x, p.y, p.z });
+			normals.insert(normals.end(), { p.x, p.y, p.z });
+		}
+		//The seam has two texture coordinates, one per side
+		for (int s = 0; s <= segments; s++) {
+			texcoords.insert(texcoords.end(), { (float)s / segments, (float)r / rings });
+		}
+	}
+
+	vector<MeshCorner> corners;
+	auto corner = [&](int r, int s) {
+		int position = r * segments + s % segments;
+		return MeshCorner{ position, position, r * (segments + 1) + s };
+	};
+	for (int r = 0; r < rings; r++) {
+		for (int s = 0; s < segments; s++) {
+			corners.insert(corners.end(), { corner(r, s), corner(r + 1, s), corner(r + 1, s + 1) });
+			corners.insert(corners.end(), { corner(r, s), corner(r + 1, s + 1), corner(r, s + 1) });
+		}
+	}
+	return corners;
+}
+
+/// <summary>
+/// Model loading: vertices and post-transform cache misses per triangle (ACMR, FIFO cache of 16)
+/// for one vertex per corner as before, indexed, and indexed with reordered triangles
+/// </summary>
+void benchMeshes() {
+	cout << "== meshes ==" << endl;
+	cout << setw(10) << "triangles" << setw(14) << "unindexed" << setw(10) << "indexed" << setw(14) << "ACMR before"
+		<< setw(16) << "ACMR indexed" << setw(16) << "ACMR optimized" << setw(12) << "build ms" << endl;
+
+	const int detail[] = { 16, 64, 256 };
+	for (int n : detail) {
+		vector<float> positions, normals, texcoords;
+		vector<MeshCorner> corners = generateSphere(n, n * 2, positions, normals, texcoords);
+
+		//Before: every corner its own vertex, so nothing is ever reused
+		vector<uint32_t> unindexed(corners.size());
+		for (size_t i = 0; i < unindexed.size(); i++) unindexed[i] = (uint32_t)i;
+
+		//Indexed in face order, without reordering
+		vector<uint32_t> plain;
+		unordered_map<long long, uint32_t> seen;
+		for (const MeshCorner& c : corners) {
+			long long key = (long long)c.position << 32 | (uint32_t)c.texcoord;
+			plain.push_back(seen.emplace(key, (uint32_t)seen.size()).first->second);
+		}
+
+		double start = now();
+		IndexedMesh mesh = buildIndexedMesh(positions, normals, texcoords, corners);
+		double elapsed = now() - start;
+
+		cout << setw(10) << corners.size() / 3 << setw(14) << corners.size() << setw(10) << mesh.vertices.size()
+			<< setw(14) << fixed << setprecision(3) << averageCacheMissRatio(unindexed) << setw(16) << averageCacheMissRatio(plain)
+			<< setw(16) << averageCacheMissRatio(mesh.indices) << setw(12) << setprecision(2) << elapsed * 1000 << endl;
+	}
+}
+
+/// <summary>
+/// Levels of detail of a sphere model: triangles and largest distance from the full surface per
+/// level, then the vertices drawn for a field of pellets seen from its middle with and without them
+/// </summary>
+void benchLods() {
+	cout << "== lods ==" << endl;
+
+	vector<float> positions, normals, texcoords;
+	vector<MeshCorner> corners = generateSphere(16, 32, positions, normals, texcoords);
+	IndexedMesh mesh = buildIndexedMesh(positions, normals, texcoords, corners);
+	double start = now();
+	vector<MeshLod> lods = generateLods(mesh, modelLods);
+	double elapsed = now() - start;
+
+	cout << setw(8) << "lod" << setw(12) << "triangles" << setw(14) << "max error" << endl;
+	for (size_t l = 0; l < lods.size(); l++) {
+		//A unit sphere, so the error of a triangle is how far its center sinks below the surface
+		double maxError = 0;
+		for (int i = lods[l].firstIndex; i < lods[l].firstIndex + lods[l].indexCount; i += 3) {
+			glm::vec3 center = (mesh.vertices[mesh.indices[i]].location + mesh.vertices[mesh.indices[i + 1]].location
+				+ mesh.vertices[mesh.indices[i + 2]].location) / 3.0f;
+			maxError = max(maxError, 1.0 - glm::length(center));
+		}
+		cout << setw(8) << l << setw(12) << lods[l].indexCount / 3 << setw(14) << fixed << setprecision(4) << maxError << endl;
+	}
+	cout << "generated in " << setprecision(2) << elapsed * 1000 << " ms" << endl;
+
+	//A pellet on every tile of an open field, the camera in the middle, levels switched at 8 and 20 tiles
+	const int field = 200;
+	const float lodDistances[] = { 8.0f, 20.0f };
+	long long full = 0, withLods = 0;
+	for (int x = 0; x < field; x++) {
+		for (int z = 0; z < field; z++) {
+			float distance = glm::length(glm::vec2(x - field / 2, z - field / 2));
+			size_t l = 0;
+			while (l < 2 && l + 1 < lods.size() && distance > lodDistances[l]) l++;
+			full += lods[0].indexCount;
+			withLods += lods[l].indexCount;
+		}
+	}
+	cout << "open " << field << "x" << field << " field: " << full << " vertices drawn without levels, " << withLods
+		<< " with (" << setprecision(1) << 100.0 * withLods / full << "%)" << endl;
+}
+
+/// <summary>
+/// Model startup with and without the mesh cache: parsing an obj file, indexing it and generating
+/// levels of detail, against hashing the obj file and mapping the cache written by the first load
+/// </summary>
+void benchMeshCache() {
+	cout << "== meshcache ==" << endl;
+	cout << setw(10) << "triangles" << setw(12) << "obj KB" << setw(12) << "cache KB" << setw(12) << "parse ms"
+		<< setw(12) << "mapped ms" << setw(10) << "speedup" << endl;
+
+	const string objPath = "meshcache_bench.obj", cachePath = objPath + ".mesh";
+	const int detail[] = { 16, 64, 256 };
+	for (int n : detail) {
+		//Same sphere as the meshes benchmark, written as obj text
+		vector<float> positions, normals, texcoords;
+		vector<MeshCorner> sphere = generateSphere(n, n * 2, positions, normals, texcoords);
+		{
+			ofstream obj(objPath);
+			for (size_t i = 0; i < positions.size(); i += 3) obj << "v " << positions[i] << " " << positions[i + 1] << " " << positions[i + 2] << "\n";
+			for (size_t i = 0; i < texcoords.size(); i += 2) obj << "vt " << texcoords[i] << " " << texcoords[i + 1] << "\n";
+			for (size_t i = 0; i < normals.size(); i += 3) obj << "vn " << normals[i] << " " << normals[i + 1] << " " << normals[i + 2] << "\n";
+			for (size_t i = 0; i < sphere.size(); i += 3) {
+				obj << "f";
+				for (size_t c = i; c < i + 3; c++) obj << " " << sphere[c].position + 1 << "/" << sphere[c].texcoord + 1 << "/" << sphere[c].normal + 1;
+				obj << "\n";
+			}
+		}
+
+		//First load: everything loadModel does without a cache, then the cache is written
+		double start = now();
+		tinyobj::attrib_t attrib;
+		vector<tinyobj::shape_t> shapes;
+		vector<tinyobj::material_t> materials;
+		string warn, err;
+		tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, objPath.c_str());
+		vector<MeshCorner> corners;
+		for (const auto& shape : shapes) {
+			for (const auto& meshIndex : shape.mesh.indices) corners.push_back({ meshIndex.vertex_index, meshIndex.normal_index, meshIndex.texcoord_index });
+		}
+		IndexedMesh mesh = buildIndexedMesh(attrib.vertices, attrib.normals, attrib.texcoords, corners);
+		vector<MeshLod> lods = generateLods(mesh, modelLods);
+		double parsed = now() - start;
+
+		MappedFile source(objPath);
+		uint64_t sourceHash = hashMeshSource(hashBytes(source.data(), source.size()));
+		size_t objSize = source.size();
+		source.close();
+		writeMeshCache(cachePath, sourceHash, mesh, lods);
+
+		//Later loads: hash the obj file, map the cache and copy the vertices out like the arena does
+		start = now();
+		MappedFile checked(objPath);
+		uint64_t currentHash = hashMeshSource(hashBytes(checked.data(), checked.size()));
+		MappedFile cache(cachePath);
+		MeshData data;
+		bool valid = readMeshCache(cache.data(), cache.size(), currentHash, data);
+		vector<Vertex> copied(data.vertices, data.vertices + data.vertexCount);
+		double mapped = now() - start;
+		benchSink += copied.size() + valid;
+
+		cout << setw(10) << corners.size() / 3 << setw(12) << objSize / 1024 << setw(12) << cache.size() / 1024
+			<< setw(12) << fixed << setprecision(2) << parsed * 1000 << setw(12) << mapped * 1000
+			<< setw(9) << setprecision(1) << parsed / mapped << "x" << (valid ? "" : " (cache rejected)") << endl;
+	}
+	remove(objPath.c_str());
+	remove(cachePath.c_str());
+}
+
+/// <summary>
+/// Level load time from text through stream tokens (the old loader), from mapped text with the
+/// hand written parser and from a mapped binary level used in place. Every path ends in a wall grid.
+/// The files were just written, so they are read from the file cache.
+/// </summary>
+void benchLevelLoad() {
+	cout << "== levelload ==" << endl;
+	cout << setw(12) << "size" << setw(10) << "text MB" << setw(10) << "bin MB" << setw(12) << "stream ms"
+		<< setw(12) << "text ms" << setw(12) << "binary ms" << setw(10) << "speedup" << endl;
+
+	struct Size { int columns, rows; };
+	const Size sizes[] = { { 28, 36 }, { 1024, 1024 }, { 8192, 8192 } };
+	const string textPath = "bench_level.txt", binaryPath = "bench_level.lvl";
+	for (const Size& size : sizes) {
+		LevelGrid maze = generateMaze(size.rows, size.columns, 1);
+		LevelTiles level;
+		level.columns = size.columns;
+		level.rows = size.rows;
+		level.parsed.resize((size_t)size.columns * size.rows);
+		for (int x = 0; x < size.rows; x++) {
+			for (int z = 0; z < size.columns; z++) {
+				level.parsed[(size_t)x * size.columns + z] = maze.isWall(x, z) ? levelWall : levelPellet;
+			}
+		}
+		level.parsed[(size_t)1 * size.columns + 1] = levelPlayer;
+		level.tiles = level.parsed.data();
+		writeLevelText(textPath, level);
+		writeLevelBinary(binaryPath, level);
+
+		//Small levels load in microseconds, repeat them for a stable time
+		int repeats = max(1, (int)(4000000 / level.parsed.size()));
+		LevelGrid grid;
+		double start = now();
+		for (int r = 0; r < repeats; r++) readLevelStream(textPath, grid);
+		double stream = (now() - start) / repeats;
+		benchSink += grid.isWall(1, 1);
+
+		start = now();
+		for (int r = 0; r < repeats; r++) readLevelFile(textPath, grid);
+		double text = (now() - start) / repeats;
+		benchSink += grid.isWall(1, 1);
+
+		start = now();
+		for (int r = 0; r < repeats; r++) readLevelFile(binaryPath, grid);
+		double binary = (now() - start) / repeats;
+		bool same = true;
+		for (int x = 0; x < size.rows && same; x++) {
+			for (int z = 0; z < size.columns && same; z++) same = grid.isWall(x, z) == maze.isWall(x, z);
+		}
+
+		MappedFile textFile(textPath), binaryFile(binaryPath);
+		cout << setw(12) << to_string(size.columns) + "x" + to_string(size.rows) << setw(10) << fixed << setprecision(2)
+			<< textFile.size() / 1048576.0 << setw(10) << binaryFile.size() / 1048576.0 << setw(12) << stream * 1000
+			<< setw(12) << text * 1000 << setw(12) << binary * 1000 << setw(9) << setprecision(1) << stream / binary << "x"
+			<< (same ? "" : " (MISMATCH)") << endl;
+	}
+	remove(textPath.c_str());
+	remove(binaryPath.c_str());
+}
+
+/// <summary>
+/// Batched ghost update cost per agent from a handful of ghosts up to 100k
+/// </summary>
+void benchGhosts() {
+	cout << "== ghosts ==" << endl;
+	cout << setw(10) << "ghosts" << setw(10) << "ticks" << setw(20) << "ns/agent/tick" << setw(20) << "ns/tile step" << endl;
+
+	LevelGrid grid = generateMaze(513, 513, 1);
+	JunctionGraph graph(grid.view());
+	const int counts[] = { 4, 64, 1024, 16384, 100000 };
+	const float dt = 1.0f / 60.0f;
+	for (int count : counts) {
+		GhostSystem ghosts = spawnGhosts(grid, graph, count);
+		vector<glm::vec3> positions(count);
+
+		//Roughly the same amount of work for every agent count
+		int ticks = max(600, 20000000 / count);
+		double start = now();
+		for (int tick = 0; tick < ticks; tick++) {
+			ghosts.update(dt, positions.data());
+		}
+		double elapsed = now() - start;
+
+		//A full second per tick makes every ghost reach a tile each update, which isolates the AI cost
+		int stepTicks = max(60, 2000000 / count);
+		start = now();
+		for (int tick = 0; tick < stepTicks; tick++) {
+			ghosts.update(1.0f, positions.data());
+		}
+		double stepElapsed = now() - start;
+		benchSink += (long long)positions[0].x;
+
+		cout << setw(10) << count << setw(10) << ticks << setw(20) << fixed << setprecision(2) << elapsed / ((double)ticks * count) * 1e9
+			<< setw(20) << stepElapsed / ((double)stepTicks * count) * 1e9 << endl;
+	}
+}
+
+/// <summary>
+/// Cost of rebuilding the shared flow field when the player changes tile, at once and
+/// a slice per step as the game does it, and of ghosts chasing by it compared to
+/// wandering. Chasing reads the field in O(1) per decision. Also checks that the
+/// sliced build ends in the same field as the full one.
+/// </summary>
+void benchFlowField() {
+	cout << "== flowfield ==" << endl;
+	cout << setw(10) << "size" << setw(16) << "rebuild ms" << setw(16) << "max step ms" << setw(10) << "steps" << setw(10) << "matches" << endl;
+
+	const int sizes[] = { 33, 129, 513, 2049 };
+	for (int n : sizes) {
+		LevelGrid grid = generateMaze(n, n, 1);
+		FlowField full(grid.view());
+		FlowField sliced(grid.view());
+
+		//Walk the target along a row like a player crossing the map, one tile per step
+		vector<int> targets;
+		for (int z = 1; z < n - 1 && targets.size() < 50; z++) {
+			for (int x = 1; x < n - 1; x++) {
+				if (grid.view().isOpen(x, z)) {
+					targets.push_back(x * n + z);
+					break;
+				}
+			}
+		}
+
+		double start = now();
+		for (int tile : targets) full.setTarget(tile / n, tile % n);
+		double elapsed = now() - start;
+
+		//Sliced builds run one after the other, each target is kept until its field is in use
+		sliced.setTarget(targets[0] / n, targets[0] % n);
+		double maxStep = 0;
+		long long steps = 0;
+		bool matches = true;
+		for (size_t i = 1; i < targets.size(); i++) {
+			sliced.moveTarget(targets[i] / n, targets[i] % n);
+			bool swapped = false;
+			while (!swapped) {
+				double stepStart = now();
+				sliced.continueBuild();
+				swapped = sliced.finishBuild();
+				maxStep = max(maxStep, now() - stepStart);
+				steps++;
+			}
+		}
+		for (int tile = 0; tile < n * n; tile++) {
+			matches = matches && sliced.getDistance(tile) == full.getDistance(tile) && sliced.getDirection(tile) == full.getDirection(tile);
+		}
+		cout << setw(10) << (to_string(n) + "x" + to_string(n)) << setw(16) << fixed << setprecision(3) << elapsed / targets.size() * 1000
+			<< setw(16) << maxStep * 1000 << setw(10) << steps / (long long)max<size_t>(1, targets.size() - 1) << setw(10) << (matches ? "yes" : "NO") << endl;
+	}
+
+	cout << setw(10) << "ghosts" << setw(20) << "wander ns/step" << setw(20) << "chase ns/step" << endl;
+	LevelGrid grid = generateMaze(513, 513, 1);
+	JunctionGraph graph(grid.view());
+	FlowField flow(grid.view());
+	flow.setTarget(257, 257);
+	const int counts[] = { 1024, 100000 };
+	for (int count : counts) {
+		double results[2];
+		for (int chasing = 0; chasing < 2; chasing++) {
+			GhostSystem ghosts = spawnGhosts(grid, graph, count, chasing ? &flow : nullptr);
+			vector<glm::vec3> positions(count);
+			int ticks = max(60, 2000000 / count);
+			double start = now();
+			for (int tick = 0; tick < ticks; tick++) {
+				ghosts.update(1.0f, positions.data());
+			}
+			results[chasing] = (now() - start) / ((double)ticks * count);
+			benchSink += (long long)positions[0].x;
+		}
+		cout << setw(10) << count << setw(20) << fixed << setprecision(2) << results[0] * 1e9 << setw(20) << results[1] * 1e9 << endl;
+	}
+}
+
+/// <summary>
+/// Parallel ghost update with 1 to N threads. Also checks that every thread count
+/// ends in exactly the same state as the single threaded run.
+/// </summary>
+void benchThreads() {
+	cout << "== threads ==" << endl;
+	cout << setw(10) << "threads" << setw(20) << "ns/agent/tick" << setw(10) << "speedup" << setw(16) << "deterministic" << endl;
+
+	LevelGrid grid = generateMaze(513, 513, 1);
+	JunctionGraph graph(grid.view());
+	const int count = 100000;
+	const int ticks = 600;
+	const float dt = 1.0f / 60.0f;
+	int maxThreads = max(1, (int)thread::hardware_concurrency());
+
+	vector<glm::vec3> reference;
+	double singleTime = 0;
+	for (int threads = 1; threads <= maxThreads; threads++) {
+		JobSystem jobs(threads);
+		GhostSystem ghosts = spawnGhosts(grid, graph, count);
+		vector<glm::vec3> positions(count);
+
+		double start = now();
+		for (int tick = 0; tick < ticks; tick++) {
+			jobs.parallelFor(count, 2048, [&](int begin, int end) {
+				ghosts.updateRange(begin, end, dt, positions.data());
+			});
+		}
+		double elapsed = now() - start;
+		if (threads == 1) {
+			singleTime = elapsed;
+			reference = positions;
+		}
+
+		cout << setw(10) << threads << setw(20) << fixed << setprecision(2) << elapsed / ((double)ticks * count) * 1e9
+			<< setw(10) << singleTime / elapsed << setw(16) << (positions == reference ? "yes" : "NO") << endl;
+	}
+}
+
+int main(int argc, char** argv) {
+	struct Benchmark { const char* name; void (*run)(); };
+	const Benchmark benchmarks[] = {
+		{ "collision", benchCollision },
+		{ "junctions", benchJunctions },
+		{ "walls", benchWalls },
+		{ "culling", benchCulling },
+		{ "pvs", benchPvs },
+		{ "meshes", benchMeshes },
+		{ "lods", benchLods },
+		{ "meshcache", benchMeshCache },
+		{ "levelload", benchLevelLoad },
+		{ "ghosts", benchGhosts },
+		{ "flowfield", benchFlowField },
+		{ "threads", benchThreads },
+	};
+
+	bool ranAny = false;
+	for (const Benchmark& bench : benchmarks) {
+		bool selected = argc < 2;
+		for (int i = 1; i < argc; i++) {
+			if (strcmp(argv[i], bench.name) == 0) selected = true;
+		}
+		if (selected) {
+			bench.run();
+			ranAny = true;
+		}
+	}
+
+	if (!ranAny) {
+		cerr << "Usage: " << argv[0] << " [benchmark ...]\nBenchmarks:";
+		for (const Benchmark& bench : benchmarks) cerr << " " << bench.name;
+		cerr << endl;
+		return EXIT_FAILURE;
+	}
+	return 0;
+}
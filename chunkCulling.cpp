@@ -0,0 +1,156 @@
+#include "chunkCulling.h"
+
+#include <cmath>
+
+/// <summary>
+/// Extracts the frustum planes from a combined projection and view matrix
+/// </summary>
+/// <param name="viewProjection">projection * view</param>
+Frustum::Frustum(const glm::mat4& viewProjection) {
+	//Rows of the matrix, glm stores columns
+	glm::vec4 rows[4];
+	for (int r = 0; r < 4; r++) {
+		rows[r] = glm::vec4(viewProjection[0][r], viewProjection[1][r], viewProjection[2][r], viewProjection[3][r]);
+	}
+
+	//Left, right, bottom, top, near, far
+	for (int i = 0; i < 3; i++) {
+		planes[i * 2] = rows[3] + rows[i];
+		planes[i * 2 + 1] = rows[3] - rows[i];
+	}
+}
+
+/// <summary>
+/// Checks if an axis aligned box is at least partly inside. Boxes near a corner of the
+/// frustum may be reported visible when they are not, never the other way around.
+/// </summary>
+/// <param name="boxMin">Smallest corner</param>
+/// <param name="boxMax">Largest corner</param>
+/// <returns>false if the box is fully outside one of the planes</returns>
+bool Frustum::intersects(glm::vec3 boxMin, glm::vec3 boxMax) const {
+	for (const glm::vec4& plane : planes) {
+		//The corner furthest along the plane normal
+		glm::vec3 corner(plane.x >= 0 ? boxMax.x : boxMin.x,
+			plane.y >= 0 ? boxMax.y : boxMin.y,
+			plane.z >= 0 ? boxMax.z : boxMin.z);
+		if (glm::dot(glm::vec3(plane), corner) + plane.w < 0) return false;
+	}
+	return true;
+}
+
+/// <summary>
+/// Cuts a level into chunks, all of them visible until the first update
+/// </summary>
+/// <param name="sizeX">Number of rows of the level</param>
+/// <param name="sizeZ">Number of columns of the level</param>
+/// <param name="_chunkSize">Tiles along each side of a chunk</param>
+/// <param name="_minY">Lowest point of anything drawn</param>
+/// <param name="_maxY">Highest point of anything drawn</param>
+ChunkCulling::ChunkCulling(int sizeX, int sizeZ, int _chunkSize, float _minY, float _maxY) {
+	chunkSize = _chunkSize;
+	chunksX = max(1, (sizeX + chunkSize - 1) / chunkSize);
+	chunksZ = max(1, (sizeZ + chunkSize - 1) / chunkSize);
+	minY = _minY;
+	maxY = _maxY;
+	visible = vector<unsigned char>((size_t)chunksX * chunksZ, 1);
+	for (int c = 0; c < chunksX * chunksZ; c++) visibleList.push_back(c);
+}
+
+bool ChunkCulling::testChunk(const Frustum& frustum, int chunk) const {
+	//Tile t covers t - 0.5 to t + 0.5
+	int cx = chunk / chunksZ, cz = chunk % chunksZ;
+	glm::vec3 boxMin(cx * chunkSize - 0.5f - margin, minY, cz * chunkSize - 0.5f - margin);
+	glm::vec3 boxMax((cx + 1) * chunkSize - 0.5f + margin, maxY, (cz + 1) * chunkSize - 0.5f + margin);
+	return frustum.intersects(boxMin, boxMax);
+}
+
+/// <summary>
+/// Tests every chunk against the camera
+/// </summary>
+/// <param name="frustum">View volume of the camera</param>
+void ChunkCulling::update(const Frustum& frustum) {
+	visibleList.clear();
+	for (int c = 0; c < chunksX * chunksZ; c++) {
+		visible[c] = testChunk(frustum, c);
+		if (visible[c]) visibleList.push_back(c);
+	}
+}
+
+/// <summary>
+/// Tests only some chunks against the camera, all others count as hidden.
+/// Costs as much as the number of candidates, not the size of the level.
+/// </summary>
+/// <param name="frustum">View volume of the camera</param>
+/// <param name="candidates">Chunks that may be visible in increasing order, e.g. from a VisibilitySet</param>
+/// <param name="count">Number of candidates</param>
+void ChunkCulling::update(const Frustum& frustum, const uint32_t* candidates, int count) {
+	for (int c : visibleList) visible[c] = 0;
+	visibleList.clear();
+	for (int i = 0; i < count; i++) {
+		int c = (int)candidates[i];
+		if (testChunk(frustum, c)) {
+			visible[c] = 1;
+			visibleList.push_back(c);
+		}
+	}
+}
+
+/// <summary>
+/// Buckets for the chunks of a level, all empty
+/// </summary>
+/// <param name="sizeX">Number of rows of the level</param>
+/// <param name="sizeZ">Number of columns of the level</param>
+/// <param name="_chunkSize">Tiles along each side of a chunk, the same as the culling's</param>
+ChunkBuckets::ChunkBuckets(int sizeX, int sizeZ, int _chunkSize) {
+	chunkSize = _chunkSize;
+	chunksX = max(1, (sizeX + chunkSize - 1) / chunkSize);
+	chunksZ = max(1, (sizeZ + chunkSize - 1) / chunkSize);
+	buckets = vector<vector<uint32_t>>((size_t)chunksX * chunksZ);
+}
+
+/// <summary>
+/// Puts an object into the bucket of the chunk at its position. Costs nothing more
+/// than finding the chunk when the object is still in the same one.
+/// </summary>
+/// <param name="object">Number of the object</param>
+/// <param name="position">Where the object is</param>
+void ChunkBuckets::place(uint32_t object, glm::vec3 position) {
+	if (object >= chunkOf.size()) {
+		chunkOf.resize(object + 1, -1);
+		slotOf.resize(object + 1, 0);
+	}
+	int chunk = chunkAtPosition(position.x, position.z, chunkSize, chunksX, chunksZ);
+	if (chunkOf[object] == chunk) return;
+
+	remove(object);
+	chunkOf[object] = chunk;
+	slotOf[object] = (uint32_t)buckets[chunk].size();
+	buckets[chunk].push_back(object);
+}
+
+/// <summary>
+/// Takes an object out of its bucket, nothing happens if it is in none
+/// </summary>
+/// <param name="object">Number of the object</param>
+void ChunkBuckets::remove(uint32_t object) {
+	if (object >= chunkOf.size() || chunkOf[object] < 0) return;
+
+	//The last object of the bucket fills the gap
+	vector<uint32_t>& bucket = buckets[chunkOf[object]];
+	uint32_t last = bucket.back();
+	bucket[slotOf[object]] = last;
+	slotOf[last] = slotOf[object];
+	bucket.pop_back();
+	chunkOf[object] = -1;
+}
+
+/// <summary>
+/// Collects the objects in some chunks, e.g. ChunkCulling::getVisibleChunks.
+/// Costs as much as the number of chunks and objects collected, not the number of objects.
+/// </summary>
+/// <param name="chunks">Chunks to collect from</param>
+/// <param name="out">Receives the objects, chunk by chunk</param>
+void ChunkBuckets::collect(const vector<int>& chunks, vector<uint32_t>& out) const {
+	out.clear();
+	for (int c : chunks) out.insert(out.end(), buckets[c].begin(), buckets[c].end());
+}
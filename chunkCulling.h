@@ -0,0 +1,94 @@
+#ifndef ChunkCulling_header
+#define ChunkCulling_header
+
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include "glm/glm/glm.hpp"
+
+using namespace std;
+
+/// <summary>
+/// The six planes of a camera's view volume, normals pointing inwards
+/// </summary>
+struct Frustum {
+	glm::vec4 planes[6];
+
+	Frustum(const glm::mat4& viewProjection);
+	bool intersects(glm::vec3 boxMin, glm::vec3 boxMax) const;
+};
+
+/// <summary>
+/// Chunk a world position falls in, positions outside the level are clamped to the nearest chunk
+/// </summary>
+inline int chunkAtPosition(float x, float z, int chunkSize, int chunksX, int chunksZ) {
+	int cx = glm::clamp((int)floor(x + 0.5f) / chunkSize, 0, chunksX - 1);
+	int cz = glm::clamp((int)floor(z + 0.5f) / chunkSize, 0, chunksZ - 1);
+	return cx * chunksZ + cz;
+}
+
+/// <summary>
+/// The level cut into square chunks of tiles. Every frame each chunk's bounding box is tested
+/// against the view frustum, and only what lies in visible chunks needs to be drawn.
+/// Chunk (cx, cz) has index cx * getChunksZ() + cz.
+/// </summary>
+class ChunkCulling {
+private:
+	int chunkSize = 16;
+	int chunksX = 0;
+	int chunksZ = 0;
+	float minY = 0, maxY = 0;
+	vector<unsigned char> visible;
+	vector<int> visibleList;    // visible chunks in index order
+
+	bool testChunk(const Frustum& frustum, int chunk) const;
+
+public:
+	//Objects may reach this far out of the tile they are counted in
+	static constexpr float margin = 1.0f;
+
+	ChunkCulling() = default;
+	ChunkCulling(int sizeX, int sizeZ, int _chunkSize, float _minY, float _maxY);
+
+	void update(const Frustum& frustum);
+	void update(const Frustum& frustum, const uint32_t* candidates, int count);
+
+	/// <summary>
+	/// Chunk a world position falls in, positions outside the level are clamped to the nearest chunk
+	/// </summary>
+	int chunkAt(float x, float z) const { return chunkAtPosition(x, z, chunkSize, chunksX, chunksZ); }
+	bool isVisible(int chunk) const { return visible[chunk] != 0; }
+	bool isVisible(glm::vec3 pos) const { return visible[chunkAt(pos.x, pos.z)] != 0; }
+
+	int getChunkSize() const { return chunkSize; }
+	int getChunksX() const { return chunksX; }
+	int getChunksZ() const { return chunksZ; }
+	int getChunkCount() const { return chunksX * chunksZ; }
+	int getVisibleCount() const { return (int)visibleList.size(); }
+	const vector<int>& getVisibleChunks() const { return visibleList; }
+};
+
+/// <summary>
+/// Objects sorted into the chunks of ChunkCulling they are in, so the objects of the visible
+/// chunks are collected without looking at any other. Objects are numbered from 0 and only
+/// change bucket when they move into another chunk.
+/// </summary>
+class ChunkBuckets {
+private:
+	int chunkSize = 16;
+	int chunksX = 0;
+	int chunksZ = 0;
+	vector<vector<uint32_t>> buckets;   // objects in every chunk
+	vector<int> chunkOf;                // chunk of every object, -1 if it was not placed
+	vector<uint32_t> slotOf;            // where every object is in its bucket
+
+public:
+	ChunkBuckets() = default;
+	ChunkBuckets(int sizeX, int sizeZ, int _chunkSize);
+
+	void place(uint32_t object, glm::vec3 position);
+	void remove(uint32_t object);
+	void collect(const vector<int>& chunks, vector<uint32_t>& out) const;
+};
+
+#endif
@@ -0,0 +1,144 @@
+#include "flowField.h"
+#include "junctionGraph.h"
+
+/// <summary>
+/// FlowField constructor, nothing is reachable until a target is set
+/// </summary>
+/// <param name="_level">Level to walk on</param>
+/// <param name="_tilesPerStep">Tiles continueBuild clears or searches per call</param>
+FlowField::FlowField(LevelView _level, uint32_t _tilesPerStep) {
+	level = _level;
+	tilesPerStep = _tilesPerStep;
+	size_t tiles = (size_t)level.sizeX * level.sizeZ;
+	for (Field* field : { &current, &next }) {
+		field->distance = vector<uint32_t>(tiles, unreachable);
+		field->direction = vector<unsigned char>(tiles, noDirection);
+		field->reached.reserve(tiles);
+	}
+}
+
+/// <summary>
+/// Moves the target and rebuilds the field at once, dropping any build in progress.
+/// The field is only rebuilt when the target tile changed.
+/// </summary>
+/// <param name="x">x tile</param>
+/// <param name="z">z tile</param>
+/// <returns>true if the field was rebuilt</returns>
+bool FlowField::setTarget(int x, int z) {
+	if (!level.isOpen(x, z)) return false;
+	int tile = x * level.sizeZ + z;
+	wantedTile = tile;
+	if (tile == current.target) {
+		building = false;
+		complete = false;
+		return false;
+	}
+
+	startBuild(tile);
+	build(SIZE_MAX);
+	return finishBuild();
+}
+
+/// <summary>
+/// Moves the target without rebuilding. The next continueBuild calls build the field
+/// for it, the current field stays in use until finishBuild swaps the new one in.
+/// The first target is built at once so there always is a field to follow.
+/// </summary>
+/// <param name="x">x tile</param>
+/// <param name="z">z tile</param>
+void FlowField::moveTarget(int x, int z) {
+	if (current.target < 0) {
+		setTarget(x, z);
+		return;
+	}
+	if (level.isOpen(x, z)) wantedTile = x * level.sizeZ + z;
+}
+
+/// <summary>
+/// Does one slice of work on the next field, starting a build if the target moved.
+/// Only touches the next field, so it can run on a job while agents read the current one.
+/// A build always runs to the end, a target that moves meanwhile is built after it.
+/// </summary>
+void FlowField::continueBuild() {
+	//Back on the tile of the current field, a build for the tile just left is not needed
+	if (wantedTile < 0 || wantedTile == current.target) {
+		building = false;
+		complete = false;
+		return;
+	}
+	if (!building) startBuild(wantedTile);
+	build(tilesPerStep);
+}
+
+/// <summary>
+/// Swaps in the next field once its build is complete. Call it when nothing reads the field.
+/// </summary>
+/// <returns>true if a new field is in use</returns>
+bool FlowField::finishBuild() {
+	if (!complete) return false;
+	swap(current, next);
+	building = false;
+	complete = false;
+	return true;
+}
+
+/// <summary>
+/// Starts building the next field for a tile
+/// </summary>
+/// <param name="tile">Target tile</param>
+void FlowField::startBuild(int tile) {
+	//A build dropped while clearing has cleared the front of its list already
+	if (clearing) next.reached.erase(next.reached.begin(), next.reached.begin() + head);
+	next.target = tile;
+	building = true;
+	clearing = true;
+	complete = false;
+	head = 0;
+}
+
+/// <summary>
+/// Clears and then searches up to a number of tiles of the next field
+/// </summary>
+/// <param name="budget">Tiles to clear or search before returning</param>
+void FlowField::build(size_t budget) {
+	vector<uint32_t>& distance = next.distance;
+	vector<unsigned char>& direction = next.direction;
+	vector<uint32_t>& queue = next.reached;
+
+	//Only the tiles the last search of this field reached need clearing
+	if (clearing) {
+		size_t end = queue.size() - head > budget ? head + budget : queue.size();
+		budget -= end - head;
+		for (; head < end; head++) {
+			size_t index = (size_t)(queue[head] >> 16) * level.sizeZ + (queue[head] & 0xFFFF);
+			distance[index] = unreachable;
+			direction[index] = noDirection;
+		}
+		if (head < queue.size()) return;
+
+		queue.clear();
+		queue.push_back((uint32_t)(next.target / level.sizeZ) << 16 | (uint32_t)(next.target % level.sizeZ));
+		distance[next.target] = 0;
+		clearing = false;
+		head = 0;
+	}
+
+	//Breadth first search outwards from the target, tiles queued as x << 16 | z
+	for (; head < queue.size() && budget > 0; head++, budget--) {
+		int cx = (int)(queue[head] >> 16), cz = (int)(queue[head] & 0xFFFF);
+		uint32_t nextDistance = distance[(size_t)cx * level.sizeZ + cz] + 1;
+		for (int d = 0; d < 4; d++) {
+			int nx = cx + dirsX[d], nz = cz + dirsZ[d];
+			if (!level.isOpen(nx, nz)) continue;
+
+			size_t neighbour = (size_t)nx * level.sizeZ + nz;
+			if (distance[neighbour] != unreachable) continue;
+
+			//The neighbour was reached from here, so its way to the target is the opposite step
+			distance[neighbour] = nextDistance;
+			direction[neighbour] = (unsigned char)(d ^ 1);
+			queue.push_back((uint32_t)nx << 16 | (uint32_t)nz);
+		}
+	}
+	complete = head == queue.size();
+}
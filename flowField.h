@@ -0,0 +1,71 @@
+#ifndef FlowField_header
+#define FlowField_header
+
+#include <vector>
+#include <cstdint>
+#include "levelGrid.h"
+
+using namespace std;
+
+/// <summary>
+/// Walking distance from every tile to one target tile, plus the direction of the
+/// first step on a shortest way there. Shared by every agent chasing that target.
+/// When the target moves, the next field is built a slice per step next to the
+/// current one and swapped in once complete, so no single step pays for a whole search.
+/// Levels can be at most 65536 tiles along each axis.
+/// </summary>
+class FlowField {
+private:
+	//One complete or partly built field, reached lists the tiles its search queued as x << 16 | z
+	struct Field {
+		vector<uint32_t> distance;
+		vector<unsigned char> direction;
+		vector<uint32_t> reached;
+		int target = -1;
+	};
+
+	LevelView level;
+	Field current;
+	Field next;
+	int wantedTile = -1;
+	uint32_t tilesPerStep = 0;
+
+	//Build of the next field: first the tiles its last search reached are cleared, then it is searched
+	bool building = false;
+	bool clearing = false;
+	bool complete = false;
+	size_t head = 0;
+
+	void startBuild(int tile);
+	void build(size_t budget);
+
+public:
+	static const uint32_t unreachable = 0xFFFFFFFF;
+	static const unsigned char noDirection = 0xFF;
+	static const uint32_t defaultTilesPerStep = 32768;
+
+	FlowField() = default;
+	FlowField(LevelView _level, uint32_t _tilesPerStep = defaultTilesPerStep);
+
+	bool setTarget(int x, int z);
+	void moveTarget(int x, int z);
+	void continueBuild();
+	bool finishBuild();
+
+	/// <summary>
+	/// Steps from a tile to the target, unreachable for walls and cut off areas
+	/// </summary>
+	uint32_t getDistance(int tile) const { return current.distance[tile]; }
+
+	/// <summary>
+	/// Direction (see dirsX/dirsZ) to step in from a tile to get closer to the target
+	/// </summary>
+	int getDirection(int tile) const { return current.direction[tile]; }
+
+	/// <summary>
+	/// Tile the current field leads to, -1 before the first target
+	/// </summary>
+	int getTarget() const { return current.target; }
+};
+
+#endif
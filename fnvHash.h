@@ -0,0 +1,24 @@
+#ifndef FnvHash_header
+#define FnvHash_header
+
+#include <cstdint>
+#include <cstddef>
+
+//FNV-1a, the fingerprint of assets, caches, levels and the simulation state
+const uint64_t fnvOffset = 14695981039346656037ull;
+const uint64_t fnvPrime = 1099511628211ull;
+
+/// <summary>
+/// FNV-1a hash of some bytes. Passing the hash of earlier bytes continues it, so several
+/// pieces hash the same as the bytes one after another.
+/// </summary>
+/// <param name="data">Bytes to hash</param>
+/// <param name="size">Number of bytes</param>
+/// <param name="hash">Hash to continue, fnvOffset to start a new one</param>
+inline uint64_t hashBytes(const void* data, size_t size, uint64_t hash = fnvOffset) {
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < size; i++) hash = (hash ^ bytes[i]) * fnvPrime;
+	return hash;
+}
+
+#endif
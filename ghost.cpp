@@ -1,149 +1,187 @@
 #include"ghost.h"
 
-extern bool gameOver;
+//Ghost height and speed in tiles per second
+const float ghostHeight = -0.65f;
+const float ghostSpeed = 1.0f;
 
 /// <summary>
-/// Ghost constructor
+/// GhostSystem constructor
 /// </summary>
-/// <param name="_level">Level data</param>
-/// <param name="_x">x position</param>
-/// <param name="_y">y position</param>
-Ghost::Ghost(std::vector<std::vector<int>> _level, int _x, int _y)
+/// <param name="_level">Shared level data</param>
+/// <param name="_graph">Junction graph of the level</param>
+/// <param name="_flow">Flow field chasing ghosts follow</param>
+GhostSystem::GhostSystem(LevelView _level, const JunctionGraph* _graph, const FlowField* _flow)
 {
-	prevGridPosition = gridPosition = glm::vec3(_x, -0.65, _y);
-	dir = glm::vec2(0, 0);
 	level = _level;
+	graph = _graph;
+	flow = _flow;
+}
+
+/// <summary>
+/// Spawns a ghost on a tile and sends it off in a random open direction
+/// </summary>
+/// <param name="x">x tile</param>
+/// <param name="z">z tile</param>
+/// <param name="random">Generator for this ghost's decisions</param>
+/// <param name="chasing">Chase the flow field target instead of wandering</param>
+/// <returns>Index of the new ghost</returns>
+int GhostSystem::addGhost(int x, int z, const Pcg32& random, bool chasing) {
+	int i = size();
+	prevX.push_back(x); prevZ.push_back(z);
+	gridX.push_back(x); gridZ.push_back(z);
+	linTime.push_back(0.0f);
+	corridor.push_back(-1);
+	runPos.push_back(0);
+	runDir.push_back(0);
+	stepsLeft.push_back(0);
+	rng.push_back(random);
+	chase.push_back(chasing && flow != nullptr);
+
+	int options[4];
+	int j = 0;
+	for (int d = 0; d < 4; d++) {
+		if (level.isOpen(x + dirsX[d], z + dirsZ[d])) options[j++] = d;
+	}
+	if (j > 0) {
+		int dir = (j == 1) ? options[0] : options[rng[i].nextBounded(j)];
+		int c, at;
+		graph->findPosition(level, x, z, dir, c, at);
+		enterCorridor(i, c, at + 1);
+	}
+	return i;
+}
 
-	//generate start direction
-	currentDir = newDirection();
+int GhostSystem::size() const {
+	return (int)linTime.size();
 }
 
 /// <summary>
-/// Finds an initial direction to travel after spawning
+/// Puts the ghost on a corridor, heading for the tile at the given step
 /// </summary>
-/// <returns>new direction</returns>
-int Ghost::newDirection() {
-	if (checkDir(1, 0)) { return 0; }
-	else if (checkDir(-1, 0)) { return 1; }
-	else if (checkDir(0, 1)) { return 2; }
-	else if (checkDir(0, -1)) { return 3; }
+void GhostSystem::enterCorridor(int i, int c, int step) {
+	corridor[i] = c;
+	runPos[i] = graph->runIndex(c, step);
+	runDir[i] = graph->runDirection(c);
+	stepsLeft[i] = graph->getCorridor(c).length - step;
+	setTarget(i);
 }
 
 /// <summary>
-///  Checks if a position is within a tunnel or not
+/// Points the ghost at the tile it is heading to
 /// </summary>
-/// <param name="dirx">check in this direction if 1 or -1</param>
-/// <param name="diry">check in this direction if 1 or -1</param>
-/// <returns>true if new position is legal</returns>
-bool Ghost::checkDir(int dirx, int diry) {
-	//Checks if new position is valid or not
-	int _x = gridPosition.x + dirx;
-	int _y = gridPosition.z + diry;
-
-	bool outOfX = (_x < 0 || _x > level.size() - 1);
-	bool outOfY = (_y < 0 || _y > level[1].size() - 1);
-	bool outOfBounds = (outOfX || outOfY);
-
-	if (!outOfBounds && level[_x][_y] != 1) return true;
-	return false;
+void GhostSystem::setTarget(int i) {
+	uint32_t tile = graph->runTile(runPos[i]);
+	gridX[i] = (float)(tile >> 16);
+	gridZ[i] = (float)(tile & 0xFFFF);
 }
 
 /// <summary>
-/// Ghost AI with three stages, Discovery, Choice & Action
-/// discovers possible moves,
-/// chooses one of all available
-/// performs that choice by moving to that location
+/// Ghost AI, called when a ghost reached the tile it was heading to.
+/// Inside a corridor it just takes the next tile. At a node it
+/// discovers the corridors that do not turn back,
+/// chooses one of all available (or turns back in a dead end)
+/// and starts walking it.
 /// </summary>
-void Ghost::move() {
-	transform = true;
+/// <param name="i">Ghost to move</param>
+void GhostSystem::move(int i) {
+	if (corridor[i] < 0) return; // boxed in, nowhere to go
 
-	int options[4] = { 0,0,0,0 };
-	int tempx, tempy;
+	prevX[i] = gridX[i];
+	prevZ[i] = gridZ[i];
 
-	//DISCOVERY
-	int j = 0;
-	for (int i = 0; i < 4; i++) {
-		switch (i)
-		{
-		case 0: tempx = 1; tempy = 0;  break;
-		case 1:	tempx = -1; tempy = 0;  break;
-		case 2: tempx = 0; tempy = 1;  break;
-		case 3: tempx = 0; tempy = -1;  break;
-		default: cerr << "Something went wrong with ghost ai"; return;
-		}
-		if (checkDir(tempx, tempy) && ((tempx != -dir.x && tempy == 0) || (tempy != -dir.y && tempx == 0))) {
-			options[j] = i;
-			j++;
-		}
+	if (stepsLeft[i] > 0) {
+		stepsLeft[i]--;
+		runPos[i] += runDir[i];
+		setTarget(i);
 	}
+	else {
+		//DISCOVERY
+		const JunctionGraph::Corridor& current = graph->getCorridor(corridor[i]);
+		const JunctionGraph::Node& node = graph->getNode(current.to);
+		int back = current.arriveDir ^ 1;
+		int options[4];
+		int j = 0;
+		for (int d = 0; d < 4; d++) {
+			if (d != back && node.corridors[d] >= 0) options[j++] = node.corridors[d];
+		}
 
-	//CHOICE
-	int choice = 0;
-	switch (j) {
-	case 0: turn = true; break;
-	case 1: currentDir = options[j - 1];	break;
-	case 2:
-		choice = rand() % 2;
-		currentDir = options[choice];	break;
-	case 3:
-		choice = rand() % 3;
-		currentDir = options[choice];	break;
-	}
+		//CHOICE
+		int next;
+		if (j == 0) next = node.corridors[back]; //If no way other than backwards, turn around
+		else if (j == 1) next = options[0];
+		else if (chase[i]) next = chooseChase(node, back, options, j);
+		else next = options[rng[i].nextBounded(j)];
 
-	//ACTION
-	switch (currentDir)
-	{
-	case 0: dir.x = 1; dir.y = 0; break; //cout << "East"  << endl; break;
-	case 1:	dir.x = -1; dir.y = 0; break; //cout << "West"  << endl; break;
-	case 2: dir.x = 0; dir.y = 1; break; //cout << "South" << endl; break;
-	case 3: dir.x = 0; dir.y = -1; break; //cout << "North" << endl; break;
-	default: cerr << "Something went wrong "; return;
+		//ACTION
+		enterCorridor(i, next, 1);
 	}
+}
 
-	//If no way other than backwards, flip the direction
-	if (turn) {
-		if (dir.x == 0) {
-			dir.y *= -1;
-		}
-		else if (dir.y == 0) {
-			dir.x *= -1;
+/// <summary>
+/// Picks the corridor that gets a chasing ghost closest to the flow field target
+/// </summary>
+/// <param name="node">Node the ghost is standing on</param>
+/// <param name="back">Direction the ghost came from, it may not go back</param>
+/// <param name="options">Corridors that do not turn back</param>
+/// <param name="count">Number of options</param>
+/// <returns>Corridor to take</returns>
+int GhostSystem::chooseChase(const JunctionGraph::Node& node, int back, const int* options, int count) const {
+	//Usually the shortest way is straight out of the field
+	int best = flow->getDirection(node.tile);
+	if (best != FlowField::noDirection && best != back) return node.corridors[best];
+
+	//The target is behind us, take whichever way forward is shortest
+	int choice = options[0];
+	uint32_t shortest = FlowField::unreachable;
+	for (int k = 0; k < count; k++) {
+		uint32_t tile = graph->runTile(graph->runIndex(options[k], 1));
+		uint32_t distance = flow->getDistance((int)(tile >> 16) * level.sizeZ + (int)(tile & 0xFFFF));
+		if (distance < shortest) {
+			shortest = distance;
+			choice = options[k];
 		}
-		turn = false;
 	}
-	prevGridPosition = gridPosition;
-
-	gridPosition.x += dir.x;
-	gridPosition.z += dir.y;
+	return choice;
 }
 
 /// <summary>
-/// Either applies movement decided by AI or calls AI to define said movement for next frame
+/// Moves every ghost along its path and lets the ones that reached a tile pick the next one
 /// </summary>
-/// <param name="dt"> Time since last frame for consistent speed</param>
-/// <returns>Returns current exact position</returns>
-glm::vec3 Ghost::updateGhost(float dt) {
-	if (transform) {
-		lerp(dt);
-	}
-	else {
-		move();
-	}
-	return exactPosition;
+/// <param name="dt">Time since last update</param>
+/// <param name="positions">Receives the exact position of every ghost</param>
+void GhostSystem::update(float dt, glm::vec3* positions) {
+	updateRange(0, size(), dt, positions);
 }
 
 /// <summary>
-/// Lerp from previous position to new position
+/// Updates the ghosts [begin, end). The result does not depend on how the ghosts are split up.
 /// </summary>
-/// <param name="dt"> Time since last frame for consistent speed</param>
-void Ghost::lerp(float dt) {
-	linTime += dt*1;
-	if (linTime <= 1) {
-		float linx = ((float)prevGridPosition.x * (1.0 - linTime)) + ((float)gridPosition.x * linTime);
-		float liny = ((float)prevGridPosition.z * (1.0 - linTime)) + ((float)gridPosition.z * linTime);
-		exactPosition = glm::vec3(liny, gridPosition.y, linx);
+/// <param name="begin">First ghost</param>
+/// <param name="end">One past the last ghost</param>
+/// <param name="dt">Time since last update</param>
+/// <param name="positions">Receives the exact position of every ghost, indexed like the ghosts</param>
+void GhostSystem::updateRange(int begin, int end, float dt, glm::vec3* positions) {
+	float* t = linTime.data();
+
+	//Advance all timers, branch free so it vectorizes
+	for (int i = begin; i < end; i++) {
+		t[i] += dt * ghostSpeed;
 	}
-	else {
-		linTime = 0;
-		transform = false;
+
+	//Only ghosts that arrived at their tile move on, and only the ones at a node decide anything
+	for (int i = begin; i < end; i++) {
+		if (t[i] >= 1.0f) {
+			t[i] = glm::min(t[i] - 1.0f, 1.0f);
+			move(i);
+		}
 	}
-}
\ No newline at end of file
+
+	//Lerp from previous tile to next tile
+	const float* px = prevX.data();
+	const float* pz = prevZ.data();
+	const float* gx = gridX.data();
+	const float* gz = gridZ.data();
+	for (int i = begin; i < end; i++) {
+		positions[i] = glm::vec3(px[i] + (gx[i] - px[i]) * t[i], ghostHeight, pz[i] + (gz[i] - pz[i]) * t[i]);
+	}
+}
@@ -2,32 +2,49 @@
 #define Ghost_header
 
 #include <vector>
-#include <iostream>
+#include <cstdint>
 #include "glm/glm/glm.hpp"
+#include "levelGrid.h"
+#include "junctionGraph.h"
+#include "flowField.h"
+#include "pcg32.h"
 
 using namespace std;
 
-class Ghost {
+/// <summary>
+/// All ghosts of a level, stored as parallel arrays so one pass updates every agent.
+/// Ghosts walk whole corridors of the junction graph and only make decisions at its nodes,
+/// either at random or towards the target of a shared flow field.
+/// A ghost only reads the level and its own entries, so disjoint ranges can update in parallel.
+/// </summary>
+class GhostSystem {
 private:
-    //Variables
-    std::vector<std::vector<int>> level;
-    glm::vec3 prevGridPosition;
-    glm::vec3 exactPosition;
-    glm::vec3 gridPosition;
-    glm::vec2 dir;
-    float linTime = 0;
-    bool transform;
-    bool turn = false;
-    int currentDir;
+    //Variables, one entry per ghost
+    LevelView level;
+    const JunctionGraph* graph = nullptr;
+    const FlowField* flow = nullptr;
+    vector<float> prevX, prevZ;     // tile the ghost is leaving
+    vector<float> gridX, gridZ;     // tile the ghost is heading to
+    vector<float> linTime;          // progress between the two tiles, 0 to 1
+    vector<int> corridor;           // corridor being walked, -1 if boxed in
+    vector<int> runPos;             // tile heading to, as index into the graph's runs
+    vector<signed char> runDir;     // which way the corridor walks the runs
+    vector<int> stepsLeft;          // steps until the end node of the corridor
+    vector<Pcg32> rng;              // every ghost draws from its own generator
+    vector<unsigned char> chase;    // follows the flow field instead of wandering
 
     //Functions
-    int newDirection();
-    bool checkDir(int _x, int _y);
-    void lerp(float dt);
-    void move();
+    void move(int i);
+    void setTarget(int i);
+    void enterCorridor(int i, int c, int step);
+    int chooseChase(const JunctionGraph::Node& node, int back, const int* options, int count) const;
 public:
-    Ghost(std::vector<std::vector<int>> _level, int _x, int _y);
-    glm::vec3 updateGhost(float dt);
+    GhostSystem() = default;
+    GhostSystem(LevelView _level, const JunctionGraph* _graph, const FlowField* _flow = nullptr);
+    int addGhost(int x, int z, const Pcg32& random, bool chasing = false);
+    void update(float dt, glm::vec3* positions);
+    void updateRange(int begin, int end, float dt, glm::vec3* positions);
+    int size() const;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,217 @@
+#include "indexedMesh.h"
+
+#include <unordered_map>
+#include <cmath>
+
+//Corners that use the same position, normal and texture coordinate are the same vertex
+struct CornerHash
+{
+	size_t operator()(const MeshCorner& c) const {
+		uint64_t key = (uint64_t)(uint32_t)c.position * 0x9E3779B97F4A7C15ull;
+		key ^= ((uint64_t)(uint32_t)c.normal + (key << 6) + (key >> 2)) * 0xC2B2AE3D27D4EB4Full;
+		key ^= ((uint64_t)(uint32_t)c.texcoord + (key << 6) + (key >> 2)) * 0x165667B19E3779F9ull;
+		return (size_t)key;
+	}
+};
+struct CornerEqual
+{
+	bool operator()(const MeshCorner& a, const MeshCorner& b) const {
+		return a.position == b.position && a.normal == b.normal && a.texcoord == b.texcoord;
+	}
+};
+
+/// <summary>
+/// Builds an indexed mesh out of the faces of an OBJ file
+/// </summary>
+/// <param name="positions">3 floats per position</param>
+/// <param name="normals">3 floats per normal</param>
+/// <param name="texcoords">2 floats per texture coordinate</param>
+/// <param name="corners">Corners of all triangles, three per triangle</param>
+/// <returns>Mesh with every distinct corner stored once, ordered for the vertex cache</returns>
+IndexedMesh buildIndexedMesh(const vector<float>& positions, const vector<float>& normals,
+	const vector<float>& texcoords, const vector<MeshCorner>& corners) {
+	IndexedMesh mesh;
+	mesh.indices.reserve(corners.size());
+	mesh.vertices.reserve(corners.size() / 2); // closed meshes share most corners
+
+	unordered_map<MeshCorner, uint32_t, CornerHash, CornerEqual> known;
+	known.reserve(corners.size());
+	for (const MeshCorner& corner : corners) {
+		auto inserted = known.emplace(corner, (uint32_t)mesh.vertices.size());
+		if (inserted.second) {
+			Vertex vertex = { glm::vec3(0.0f), glm::vec3(0.0f), glm::vec2(0.0f) };
+			if (corner.position >= 0) {
+				vertex.location = glm::vec3(positions[corner.position * 3], positions[corner.position * 3 + 1], positions[corner.position * 3 + 2]);
+			}
+			if (corner.normal >= 0) {
+				vertex.normals = glm::vec3(normals[corner.normal * 3], normals[corner.normal * 3 + 1], normals[corner.normal * 3 + 2]);
+			}
+			if (corner.texcoord >= 0) {
+				vertex.texCoords = glm::vec2(texcoords[corner.texcoord * 2], texcoords[corner.texcoord * 2 + 1]);
+			}
+			mesh.vertices.push_back(vertex);
+		}
+		mesh.indices.push_back(inserted.first->second);
+	}
+
+	optimizeVertexCache(mesh.indices, mesh.vertices.size());
+	optimizeVertexFetch(mesh);
+	return mesh;
+}
+
+//Cache size the triangle order is scored for, larger than real caches so it suits all of them
+const int scoringCacheSize = 32;
+
+/// <summary>
+/// How much drawing a vertex next is worth: a lot if it was just used and is still
+/// in the cache, and more the fewer triangles are left that use it
+/// </summary>
+static float vertexScore(int cachePosition, uint32_t remaining) {
+	if (remaining == 0) return -1.0f;
+
+	float score = 0.0f;
+	if (cachePosition >= 0) {
+		//The last triangle's vertices get a fixed score so its neighbours are not preferred over each other
+		if (cachePosition < 3) score = 0.75f;
+		else score = pow(1.0f - (float)(cachePosition - 3) / (scoringCacheSize - 3), 1.5f);
+	}
+	return score + 2.0f / sqrt((float)remaining);
+}
+
+/// <summary>
+/// Reorders triangles so that vertices are reused while the GPU still has them transformed
+/// (Forsyth's linear speed vertex cache optimisation). Each step draws the best scoring
+/// triangle among those sharing a vertex with the recent ones.
+/// </summary>
+/// <param name="indices">Three indices per triangle, reordered in place</param>
+/// <param name="vertexCount">Number of vertices the indices refer to</param>
+void optimizeVertexCache(vector<uint32_t>& indices, size_t vertexCount) {
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0) return;
+
+	//Triangles of every vertex, the first remaining[v] of them are not drawn yet
+	vector<uint32_t> remaining(vertexCount, 0);
+	for (uint32_t v : indices) remaining[v]++;
+	vector<uint32_t> firstTriangle(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; v++) firstTriangle[v + 1] = firstTriangle[v] + remaining[v];
+	vector<uint32_t> triangles(indices.size());
+	vector<uint32_t> fill(firstTriangle.begin(), firstTriangle.end() - 1);
+	for (size_t i = 0; i < indices.size(); i++) triangles[fill[indices[i]]++] = (uint32_t)(i / 3);
+
+	vector<int> cachePosition(vertexCount, -1);
+	vector<float> score(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++) score[v] = vertexScore(-1, remaining[v]);
+	vector<float> triangleScore(triangleCount);
+	vector<bool> drawn(triangleCount, false);
+	int best = 0;
+	for (size_t t = 0; t < triangleCount; t++) {
+		triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+		if (triangleScore[t] > triangleScore[best]) best = (int)t;
+	}
+
+	vector<uint32_t> order;
+	order.reserve(indices.size());
+	vector<uint32_t> cache, nextCache;
+	size_t scan = 0;
+	while (order.size() < indices.size()) {
+		//Nothing in the cache touches an undrawn triangle, continue with the next one in the original order
+		if (best < 0) {
+			while (drawn[scan]) scan++;
+			best = (int)scan;
+		}
+
+		const uint32_t* corners = &indices[(size_t)best * 3];
+		drawn[best] = true;
+		order.insert(order.end(), corners, corners + 3);
+
+		//Take the triangle out of its vertices' lists
+		for (int c = 0; c < 3; c++) {
+			uint32_t v = corners[c];
+			uint32_t* list = &triangles[firstTriangle[v]];
+			for (uint32_t i = 0; i < remaining[v]; i++) {
+				if (list[i] == (uint32_t)best) {
+					swap(list[i], list[remaining[v] - 1]);
+					break;
+				}
+			}
+			remaining[v]--;
+		}
+
+		//The triangle's vertices move to the front of the cache, the oldest fall out
+		nextCache.assign(corners, corners + 3);
+		for (uint32_t v : cache) {
+			if (v != corners[0] && v != corners[1] && v != corners[2]) nextCache.push_back(v);
+		}
+		for (size_t i = 0; i < nextCache.size(); i++) {
+			uint32_t v = nextCache[i];
+			cachePosition[v] = i < scoringCacheSize ? (int)i : -1;
+			float change = vertexScore(cachePosition[v], remaining[v]) - score[v];
+			score[v] += change;
+			for (uint32_t t = 0; t < remaining[v]; t++) triangleScore[triangles[firstTriangle[v] + t]] += change;
+		}
+		if (nextCache.size() > scoringCacheSize) nextCache.resize(scoringCacheSize);
+		cache.swap(nextCache);
+
+		//Best undrawn triangle around the cached vertices
+		best = -1;
+		float bestScore = -1.0f;
+		for (uint32_t v : cache) {
+			for (uint32_t t = 0; t < remaining[v]; t++) {
+				uint32_t triangle = triangles[firstTriangle[v] + t];
+				if (triangleScore[triangle] > bestScore) {
+					bestScore = triangleScore[triangle];
+					best = (int)triangle;
+				}
+			}
+		}
+	}
+	indices.swap(order);
+}
+
+/// <summary>
+/// Stores vertices in the order the triangles first use them, so vertex reads move through memory
+/// </summary>
+/// <param name="mesh">Mesh to reorder</param>
+void optimizeVertexFetch(IndexedMesh& mesh) {
+	const uint32_t unused = 0xFFFFFFFF;
+	vector<uint32_t> remap(mesh.vertices.size(), unused);
+	vector<Vertex> ordered;
+	ordered.reserve(mesh.vertices.size());
+	for (uint32_t& index : mesh.indices) {
+		if (remap[index] == unused) {
+			remap[index] = (uint32_t)ordered.size();
+			ordered.push_back(mesh.vertices[index]);
+		}
+		index = remap[index];
+	}
+	mesh.vertices.swap(ordered);
+}
+
+/// <summary>
+/// Vertices transformed per triangle with a FIFO post-transform cache, 0.5 is the best possible
+/// on big closed meshes and 3 means no reuse at all
+/// </summary>
+/// <param name="indices">Three indices per triangle</param>
+/// <param name="cacheSize">Vertices the simulated cache holds</param>
+/// <returns>Average cache misses per triangle</returns>
+float averageCacheMissRatio(const vector<uint32_t>& indices, int cacheSize) {
+	if (indices.empty()) return 0.0f;
+
+	vector<uint32_t> fifo(cacheSize, 0xFFFFFFFF);
+	size_t next = 0, misses = 0;
+	for (uint32_t index : indices) {
+		bool hit = false;
+		for (uint32_t cached : fifo) {
+			if (cached == index) {
+				hit = true;
+				break;
+			}
+		}
+		if (!hit) {
+			fifo[next] = index;
+			next = (next + 1) % cacheSize;
+			misses++;
+		}
+	}
+	return (float)misses / (indices.size() / 3);
+}
@@ -0,0 +1,44 @@
+#ifndef IndexedMesh_header
+#define IndexedMesh_header
+
+#include <vector>
+#include <cstdint>
+#include "glm/glm/glm.hpp"
+
+using namespace std;
+
+//Data structure for one vertex of a loaded model, uploaded to OpenGL as is
+struct Vertex
+{
+	glm::vec3 location;
+	glm::vec3 normals;
+	glm::vec2 texCoords;
+};
+
+//One corner of a face in an OBJ file: indices into its position, normal and texture coordinate
+//lists, -1 where the file has none
+struct MeshCorner
+{
+	int position;
+	int normal;
+	int texcoord;
+};
+
+/// <summary>
+/// Triangle mesh where every distinct vertex is stored once and triangles refer to it by index.
+/// Triangles are ordered to reuse recently transformed vertices, and vertices are stored in the
+/// order the triangles first use them.
+/// </summary>
+struct IndexedMesh
+{
+	vector<Vertex> vertices;
+	vector<uint32_t> indices;
+};
+
+IndexedMesh buildIndexedMesh(const vector<float>& positions, const vector<float>& normals,
+	const vector<float>& texcoords, const vector<MeshCorner>& corners);
+void optimizeVertexCache(vector<uint32_t>& indices, size_t vertexCount);
+void optimizeVertexFetch(IndexedMesh& mesh);
+float averageCacheMissRatio(const vector<uint32_t>& indices, int cacheSize = 16);
+
+#endif
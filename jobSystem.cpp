@@ -0,0 +1,139 @@
+#include "jobSystem.h"
+
+//Which job system and queue the current thread belongs to
+thread_local const JobSystem* threadOwner = nullptr;
+thread_local int threadIndex = 0;
+
+/// <summary>
+/// Starts the worker threads
+/// </summary>
+/// <param name="threadCount">Threads to work on, including the calling thread</param>
+JobSystem::JobSystem(int threadCount) {
+	if (threadCount < 1) threadCount = 1;
+	for (int i = 0; i < threadCount; i++) {
+		queues.push_back(make_unique<Queue>());
+	}
+	threadOwner = this;
+	threadIndex = 0;
+	for (int i = 1; i < threadCount; i++) {
+		workers.push_back(thread(&JobSystem::workerLoop, this, i));
+	}
+}
+
+JobSystem::~JobSystem() {
+	{
+		lock_guard<mutex> guard(sleepLock);
+		running = false;
+	}
+	wakeUp.notify_all();
+	for (auto& worker : workers) worker.join();
+	if (threadOwner == this) threadOwner = nullptr;
+}
+
+int JobSystem::getThreadCount() const {
+	return (int)queues.size();
+}
+
+int JobSystem::currentThread() const {
+	return threadOwner == this ? threadIndex : 0;
+}
+
+/// <summary>
+/// Queues a job on the calling thread's queue
+/// </summary>
+/// <param name="counter">Counter that is decremented once the job finished</param>
+/// <param name="work">Job to run</param>
+void JobSystem::run(JobCounter& counter, function<void()> work) {
+	counter.pending++;
+	Queue& queue = *queues[currentThread()];
+	{
+		lock_guard<mutex> guard(queue.lock);
+		queue.jobs.push_back(Job{ move(work), &counter });
+	}
+	{
+		//Taken so a worker can not miss the wake up between checking for jobs and sleeping
+		lock_guard<mutex> guard(sleepLock);
+		queuedJobs++;
+	}
+	wakeUp.notify_one();
+}
+
+/// <summary>
+/// Takes the newest job of the own queue, or steals the oldest job of another one
+/// </summary>
+/// <param name="thread">Index of the calling thread</param>
+/// <param name="job">Receives the job</param>
+/// <returns>true if a job was found</returns>
+bool JobSystem::popJob(int thread, Job& job) {
+	int count = (int)queues.size();
+	for (int i = 0; i < count; i++) {
+		Queue& queue = *queues[(thread + i) % count];
+		lock_guard<mutex> guard(queue.lock);
+		if (queue.jobs.empty()) continue;
+
+		if (i == 0) {
+			job = move(queue.jobs.back());
+			queue.jobs.pop_back();
+		}
+		else {
+			job = move(queue.jobs.front());
+			queue.jobs.pop_front();
+		}
+		queuedJobs--;
+		return true;
+	}
+	return false;
+}
+
+bool JobSystem::runOneJob(int thread) {
+	Job job;
+	if (!popJob(thread, job)) return false;
+	job.work();
+	job.counter->pending--;
+	return true;
+}
+
+void JobSystem::workerLoop(int thread) {
+	threadOwner = this;
+	threadIndex = thread;
+	while (true) {
+		if (runOneJob(thread)) continue;
+
+		unique_lock<mutex> guard(sleepLock);
+		wakeUp.wait(guard, [this] { return !running || queuedJobs > 0; });
+		if (!running) return;
+	}
+}
+
+/// <summary>
+/// Runs queued jobs on the calling thread until all jobs of a counter finished
+/// </summary>
+/// <param name="counter">Counter to wait for</param>
+void JobSystem::wait(JobCounter& counter) {
+	int thread = currentThread();
+	while (counter.pending > 0) {
+		if (!runOneJob(thread)) this_thread::yield();
+	}
+}
+
+/// <summary>
+/// Splits [0, count) into pieces of at most grain items and runs them on all threads.
+/// Returns once every piece is done.
+/// </summary>
+/// <param name="count">Number of items</param>
+/// <param name="grain">Items per job</param>
+/// <param name="body">Called with each [begin, end) piece</param>
+void JobSystem::parallelFor(int count, int grain, const function<void(int begin, int end)>& body) {
+	if (grain < 1) grain = 1;
+	if (queues.size() == 1 || count <= grain) {
+		if (count > 0) body(0, count);
+		return;
+	}
+
+	JobCounter counter;
+	for (int begin = 0; begin < count; begin += grain) {
+		int end = min(begin + grain, count);
+		run(counter, [&body, begin, end] { body(begin, end); });
+	}
+	wait(counter);
+}
@@ -0,0 +1,59 @@
+#ifndef JobSystem_header
+#define JobSystem_header
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+using namespace std;
+
+//Counts jobs that have not finished yet, wait() on it to join them
+struct JobCounter {
+	atomic<int> pending{ 0 };
+};
+
+/// <summary>
+/// Small work stealing job system. Every thread owns a queue, takes its newest
+/// job first and steals the oldest jobs of the other threads when it runs dry.
+/// The thread that created the system is thread 0 and helps out while waiting.
+/// </summary>
+class JobSystem {
+private:
+	struct Job {
+		function<void()> work;
+		JobCounter* counter;
+	};
+	struct Queue {
+		mutex lock;
+		deque<Job> jobs;
+	};
+
+	vector<unique_ptr<Queue>> queues;
+	vector<thread> workers;
+	atomic<bool> running{ true };
+	atomic<int> queuedJobs{ 0 };
+	mutex sleepLock;
+	condition_variable wakeUp;
+
+	int currentThread() const;
+	bool popJob(int thread, Job& job);
+	bool runOneJob(int thread);
+	void workerLoop(int thread);
+public:
+	JobSystem(int threadCount);
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+	~JobSystem();
+
+	int getThreadCount() const;
+	void run(JobCounter& counter, function<void()> work);
+	void wait(JobCounter& counter);
+	void parallelFor(int count, int grain, const function<void(int begin, int end)>& body);
+};
+
+#endif
@@ -0,0 +1,171 @@
+#include "junctionGraph.h"
+
+#include <algorithm>
+
+/// <summary>
+/// Builds the graph of a level. Every walkable tile that does not have exactly two
+/// walkable neighbours becomes a node, then the corridors between them are traced.
+/// </summary>
+/// <param name="level">Level to build the graph for</param>
+JunctionGraph::JunctionGraph(LevelView level) {
+	sizeZ = level.sizeZ;
+
+	//Nodes wherever a ghost can not just follow the corridor, found in tile order
+	for (int x = 0; x < level.sizeX; x++) {
+		for (int z = 0; z < level.sizeZ; z++) {
+			if (level.isOpen(x, z) && degree(level, x, z) != 2) {
+				nodes.push_back(Node{ x * sizeZ + z, { -1, -1, -1, -1 } });
+			}
+		}
+	}
+	sortedNodes = (int)nodes.size();
+
+	vector<bool> visited((size_t)level.sizeX * level.sizeZ, false);
+	for (int n = 0; n < sortedNodes; n++) {
+		for (int d = 0; d < 4; d++) {
+			int x = nodes[n].tile / sizeZ + dirsX[d], z = nodes[n].tile % sizeZ + dirsZ[d];
+			if (nodes[n].corridors[d] == -1 && level.isOpen(x, z)) traceCorridor(level, n, d, visited);
+		}
+	}
+
+	//Corridors that loop back into themselves without a junction get one of their tiles as node
+	for (int x = 0; x < level.sizeX; x++) {
+		for (int z = 0; z < level.sizeZ; z++) {
+			int tile = x * sizeZ + z;
+			if (!level.isOpen(x, z) || visited[tile] || degree(level, x, z) != 2) continue;
+
+			int n = (int)nodes.size();
+			nodes.push_back(Node{ tile, { -1, -1, -1, -1 } });
+			extraNodes[tile] = n;
+			visited[tile] = true;
+			for (int d = 0; d < 4; d++) {
+				if (nodes[n].corridors[d] == -1 && level.isOpen(x + dirsX[d], z + dirsZ[d])) traceCorridor(level, n, d, visited);
+			}
+		}
+	}
+}
+
+int JunctionGraph::degree(LevelView level, int x, int z) const {
+	int count = 0;
+	for (int d = 0; d < 4; d++) {
+		if (level.isOpen(x + dirsX[d], z + dirsZ[d])) count++;
+	}
+	return count;
+}
+
+/// <summary>
+/// Looks up the node on a tile
+/// </summary>
+/// <param name="tile">Tile index</param>
+/// <returns>Node index, or -1 if the tile is inside a corridor</returns>
+int JunctionGraph::findNode(int tile) const {
+	auto end = nodes.begin() + sortedNodes;
+	auto it = lower_bound(nodes.begin(), end, tile, [](const Node& node, int t) { return node.tile < t; });
+	if (it != end && it->tile == tile) return (int)(it - nodes.begin());
+
+	auto extra = extraNodes.find(tile);
+	return extra != extraNodes.end() ? extra->second : -1;
+}
+
+/// <summary>
+/// Follows a corridor from a node until the next node and adds it in both directions
+/// </summary>
+/// <param name="level">Level the graph is built for</param>
+/// <param name="node">Node to start at</param>
+/// <param name="dir">Direction to leave the node in</param>
+/// <param name="visited">Marks corridor tiles that are part of a run</param>
+void JunctionGraph::traceCorridor(LevelView level, int node, int dir, vector<bool>& visited) {
+	int runStart = (int)runs.size();
+	runs.push_back((uint32_t)(nodes[node].tile / sizeZ) << 16 | (uint32_t)(nodes[node].tile % sizeZ));
+
+	int x = nodes[node].tile / sizeZ + dirsX[dir];
+	int z = nodes[node].tile % sizeZ + dirsZ[dir];
+	int lastDir = dir;
+	int end;
+	while (true) {
+		int tile = x * sizeZ + z;
+		runs.push_back((uint32_t)x << 16 | (uint32_t)z);
+
+		//Junctions and dead ends never have two neighbours, so only those need a lookup
+		if (degree(level, x, z) != 2 || (!extraNodes.empty() && extraNodes.count(tile))) {
+			end = findNode(tile);
+			break;
+		}
+		visited[tile] = true;
+
+		//Inside a corridor there is exactly one way on that does not turn back
+		for (int d = 0; d < 4; d++) {
+			if (d != (lastDir ^ 1) && level.isOpen(x + dirsX[d], z + dirsZ[d])) {
+				lastDir = d;
+				break;
+			}
+		}
+		x += dirsX[lastDir];
+		z += dirsZ[lastDir];
+	}
+
+	int length = (int)runs.size() - runStart - 1;
+	int there = (int)corridors.size();
+	corridors.push_back(Corridor{ node, end, runStart, length, true, (signed char)lastDir });
+	corridors.push_back(Corridor{ end, node, runStart, length, false, (signed char)(dir ^ 1) });
+	nodes[node].corridors[dir] = there;
+	nodes[end].corridors[lastDir ^ 1] = there + 1;
+}
+
+/// <summary>
+/// Position in the shared runs of the tile a given number of steps into a corridor.
+/// The following steps are found by adding runDirection to it.
+/// </summary>
+/// <param name="corridor">Corridor to walk</param>
+/// <param name="step">0 is the start node, length is the end node</param>
+/// <returns>Index for runTile</returns>
+int JunctionGraph::runIndex(int corridor, int step) const {
+	const Corridor& c = corridors[corridor];
+	return c.runStart + (c.forward ? step : c.length - step);
+}
+
+/// <summary>
+/// Finds the corridor and step of a ghost standing on a tile and heading in a direction
+/// </summary>
+/// <param name="level">Level the graph was built for</param>
+/// <param name="x">x tile</param>
+/// <param name="z">z tile</param>
+/// <param name="dir">Direction the ghost is heading, must lead to a walkable tile</param>
+/// <param name="corridor">Receives the corridor</param>
+/// <param name="step">Receives the step of the tile within the corridor</param>
+/// <returns>false if the tile is not walkable</returns>
+bool JunctionGraph::findPosition(LevelView level, int x, int z, int dir, int& corridor, int& step) const {
+	if (!level.isOpen(x, z) || !level.isOpen(x + dirsX[dir], z + dirsZ[dir])) return false;
+
+	int node = findNode(x * sizeZ + z);
+	if (node >= 0) {
+		corridor = nodes[node].corridors[dir];
+		step = 0;
+		return true;
+	}
+
+	//Walk backwards to the node behind us and count the steps
+	int lastDir = 0;
+	for (int d = 0; d < 4; d++) {
+		if (d != dir && level.isOpen(x + dirsX[d], z + dirsZ[d])) {
+			lastDir = d;
+			break;
+		}
+	}
+	x += dirsX[lastDir];
+	z += dirsZ[lastDir];
+	step = 1;
+	while ((node = findNode(x * sizeZ + z)) < 0) {
+		for (int d = 0; d < 4; d++) {
+			if (d != (lastDir ^ 1) && level.isOpen(x + dirsX[d], z + dirsZ[d])) {
+				lastDir = d;
+				break;
+			}
+		}
+		x += dirsX[lastDir];
+		z += dirsZ[lastDir];
+		step++;
+	}
+	corridor = nodes[node].corridors[lastDir ^ 1];
+	return true;
+}
@@ -0,0 +1,63 @@
+#ifndef JunctionGraph_header
+#define JunctionGraph_header
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "levelGrid.h"
+
+using namespace std;
+
+//Directions in the order the ghost AI probes them: east, west, south, north.
+//The opposite of direction d is d ^ 1.
+const int dirsX[4] = { 0, 0, 1, -1 };
+const int dirsZ[4] = { 1, -1, 0, 0 };
+
+/// <summary>
+/// Walkable tiles reduced to the places where a choice can be made.
+/// Nodes are junctions and dead ends, corridors are the runs of tiles between them.
+/// A corridor is directed, its way back is a separate corridor sharing the same tiles.
+/// Levels can be at most 65536 tiles along each axis.
+/// </summary>
+class JunctionGraph {
+public:
+	struct Node {
+		int tile;
+		int corridors[4];   // corridor leaving in each direction, -1 if blocked
+	};
+	struct Corridor {
+		int from, to;       // nodes at both ends
+		int runStart;       // first tile of the shared run in runs
+		int length;         // steps from one node to the other
+		bool forward;       // walks the shared run front to back
+		signed char arriveDir; // direction of the last step into the end node
+	};
+
+private:
+	int sizeZ = 0;
+	vector<Node> nodes;
+	vector<Corridor> corridors;
+	vector<uint32_t> runs;  // tiles of every corridor including both end nodes, packed as x << 16 | z
+	int sortedNodes = 0;    // nodes found by degree are sorted by tile
+	unordered_map<int, int> extraNodes; // nodes added to break up loops without junctions
+
+	int degree(LevelView level, int x, int z) const;
+	int findNode(int tile) const;
+	void traceCorridor(LevelView level, int node, int dir, vector<bool>& visited);
+
+public:
+	JunctionGraph() = default;
+	JunctionGraph(LevelView level);
+
+	int runIndex(int corridor, int step) const;
+	int runDirection(int corridor) const { return corridors[corridor].forward ? 1 : -1; }
+	uint32_t runTile(int index) const { return runs[index]; }
+	bool findPosition(LevelView level, int x, int z, int dir, int& corridor, int& step) const;
+
+	const Node& getNode(int node) const { return nodes[node]; }
+	const Corridor& getCorridor(int corridor) const { return corridors[corridor]; }
+	int nodeCount() const { return (int)nodes.size(); }
+	int corridorCount() const { return (int)corridors.size(); }
+};
+
+#endif
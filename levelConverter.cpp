@@ -0,0 +1,37 @@
+//Level converter, turns text levels into binary levels the game maps and uses in place, and back for editing
+#include "levelFile.h"
+#include "mappedFile.h"
+
+#include <iostream>
+#include <cstring>
+
+int main(int argc, char** argv) {
+	bool toText = argc == 4 && strcmp(argv[1], "--text") == 0;
+	if (argc != 3 && !toText) {
+		cerr << "Usage: " << argv[0] << " [--text] <input level> <output level>\n"
+			<< "Writes the binary format, or the text format with --text. The input can be either." << endl;
+		return 1;
+	}
+	const char* inputPath = argv[argc - 2];
+	const char* outputPath = argv[argc - 1];
+
+	MappedFile input(inputPath);
+	LevelTiles level;
+	if (!input.isOpen() || !readLevelTiles(input.data(), input.size(), level)) {
+		cerr << "Unable to read level " << inputPath << endl;
+		return 1;
+	}
+
+	size_t walls = 0, pellets = 0, players = 0;
+	for (size_t i = 0; i < (size_t)level.columns * level.rows; i++) {
+		walls += level.tiles[i] == levelWall;
+		pellets += level.tiles[i] == levelPellet;
+		players += level.tiles[i] == levelPlayer;
+	}
+	if (players != 1) cout << "Warning: the level has " << players << " player tiles, the game needs exactly one" << endl;
+
+	if (!(toText ? writeLevelText(outputPath, level) : writeLevelBinary(outputPath, level))) return 1;
+	cout << inputPath << " -> " << outputPath << ": " << level.columns << "x" << level.rows << ", " << walls << " walls, "
+		<< pellets << " pellets" << endl;
+	return 0;
+}
@@ -0,0 +1,127 @@
+#include "levelFile.h"
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+
+/// <summary>
+/// Reads a level in either format. A binary level is used in place, the tiles point into
+/// the mapped bytes, which must stay mapped while the level is used.
+/// </summary>
+/// <param name="bytes">Mapped level file</param>
+/// <param name="size">Size of the file</param>
+/// <param name="level">Receives the level</param>
+/// <returns>false if the level is damaged, or binary in an unknown version</returns>
+bool readLevelTiles(const unsigned char* bytes, size_t size, LevelTiles& level) {
+	if (!bytes) return false;
+	uint32_t magic = 0;
+	if (size >= sizeof(magic)) memcpy(&magic, bytes, sizeof(magic));
+	if (magic != levelMagic) return parseLevelText(bytes, size, level);
+
+	LevelFileHeader header;
+	if (size < sizeof(header)) return false;
+	memcpy(&header, bytes, sizeof(header));
+	if (header.version != levelVersion) {
+		cout << "Level format version " << header.version << " is not supported, expected " << levelVersion << endl;
+		return false;
+	}
+	if (header.columns == 0 || header.rows == 0 || header.columns > INT32_MAX || header.rows > INT32_MAX ||
+		size - sizeof(header) != (uint64_t)header.columns * header.rows) {
+		return false;
+	}
+
+	level.columns = (int)header.columns;
+	level.rows = (int)header.rows;
+	level.tiles = bytes + sizeof(header);
+	level.parsed.clear();
+	return true;
+}
+
+/// <summary>
+/// Parses a text level, see README for the format. Tile values above 255 are stored as 255.
+/// </summary>
+/// <param name="bytes">Text of the level</param>
+/// <param name="size">Number of bytes</param>
+/// <param name="level">Receives the level</param>
+/// <returns>false if the size line is missing or there are fewer tiles than it says</returns>
+bool parseLevelText(const unsigned char* bytes, size_t size, LevelTiles& level) {
+	const unsigned char* next = bytes;
+	const unsigned char* end = bytes + size;
+	auto skipSpace = [&]() { while (next < end && (*next == ' ' || *next == '\t' || *next == '\r' || *next == '\n')) next++; };
+	auto readNumber = [&](uint64_t limit, uint64_t& value) {
+		const unsigned char* first = next;
+		value = 0;
+		while (next < end && *next >= '0' && *next <= '9') {
+			value = value * 10 + (*next++ - '0');
+			if (value > limit) value = limit;
+		}
+		return next > first;
+	};
+
+	//Size line "<columns>x<rows>", any number of digits each
+	uint64_t columns, rows;
+	skipSpace();
+	if (!readNumber(INT32_MAX, columns) || next >= end || (*next != 'x' && *next != 'X')) return false;
+	next++;
+	if (!readNumber(INT32_MAX, rows) || columns == 0 || rows == 0) return false;
+
+	//Every tile takes at least a digit and a separator, larger sizes cannot be in the file
+	uint64_t count = columns * rows;
+	if (count > (uint64_t)(end - next) / 2 + 1) return false;
+
+	level.columns = (int)columns;
+	level.rows = (int)rows;
+	level.parsed.resize((size_t)count);
+	for (size_t i = 0; i < count; i++) {
+		uint64_t value;
+		skipSpace();
+		if (!readNumber(255, value)) return false;
+		level.parsed[i] = (unsigned char)value;
+	}
+	level.tiles = level.parsed.data();
+	return true;
+}
+
+/// <summary>
+/// Writes a level in the binary format
+/// </summary>
+/// <param name="path">File to write</param>
+/// <param name="level">Level to write</param>
+/// <returns>false if the file could not be written</returns>
+bool writeLevelBinary(const string& path, const LevelTiles& level) {
+	ofstream file(path, ios::binary);
+	if (!file) {
+		cout << "Unable to write level " << path << endl;
+		return false;
+	}
+	LevelFileHeader header = { levelMagic, levelVersion, (uint32_t)level.columns, (uint32_t)level.rows };
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)level.tiles, (streamsize)level.columns * level.rows);
+	return (bool)file;
+}
+
+/// <summary>
+/// Writes a level in the text format, one line per row
+/// </summary>
+/// <param name="path">File to write</param>
+/// <param name="level">Level to write</param>
+/// <returns>false if the file could not be written</returns>
+bool writeLevelText(const string& path, const LevelTiles& level) {
+	ofstream file(path, ios::binary);
+	if (!file) {
+		cout << "Unable to write level " << path << endl;
+		return false;
+	}
+	file << level.columns << "x" << level.rows << "\n";
+	string line;
+	for (int row = 0; row < level.rows; row++) {
+		line.clear();
+		for (int column = 0; column < level.columns; column++) {
+			if (column > 0) line += ' ';
+			line += to_string(level.at(row, column));
+		}
+		line += '\n';
+		file << line;
+	}
+	return (bool)file;
+}
@@ -0,0 +1,42 @@
+#ifndef LevelFile_header
+#define LevelFile_header
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+using namespace std;
+
+//Tile values of a level, the same in the text and the binary format
+const unsigned char levelPellet = 0;
+const unsigned char levelWall = 1;
+const unsigned char levelPlayer = 2;
+
+//Layout of a binary level: the header, then one byte per tile, rows after each other
+const uint32_t levelMagic = 0x4C56454C; // "LEVL"
+const uint32_t levelVersion = 1;
+struct LevelFileHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t columns;
+	uint32_t rows;
+};
+
+//Tiles of a level, pointing into a mapped binary level or into tiles parsed from text
+struct LevelTiles
+{
+	int columns = 0;
+	int rows = 0;
+	const unsigned char* tiles = nullptr;
+	vector<unsigned char> parsed;   // only used for text levels
+
+	unsigned char at(int row, int column) const { return tiles[(size_t)row * columns + column]; }
+};
+
+bool readLevelTiles(const unsigned char* bytes, size_t size, LevelTiles& level);
+bool parseLevelText(const unsigned char* bytes, size_t size, LevelTiles& level);
+bool writeLevelBinary(const string& path, const LevelTiles& level);
+bool writeLevelText(const string& path, const LevelTiles& level);
+
+#endif
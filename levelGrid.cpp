@@ -0,0 +1,40 @@
+#include "levelGrid.h"
+
+#include <cmath>
+
+/// <summary>
+/// Creates an open level of the given size
+/// </summary>
+/// <param name="_sizeX">Number of rows</param>
+/// <param name="_sizeZ">Number of columns</param>
+LevelGrid::LevelGrid(int _sizeX, int _sizeZ) {
+	sizeX = _sizeX;
+	sizeZ = _sizeZ;
+	tiles = vector<unsigned char>((size_t)sizeX * sizeZ, 0);
+}
+
+void LevelGrid::setWall(int x, int z, bool wall) {
+	tiles[(size_t)x * sizeZ + z] = wall ? 1 : 0;
+}
+
+/// <summary>
+/// Checks if a square around a position touches any wall segment.
+/// Only the tiles whose walls can reach the square are looked at.
+/// </summary>
+/// <param name="pos">Center of the square</param>
+/// <param name="halfSize">Distance from wall center at which walls collide</param>
+/// <returns>true if a wall overlaps</returns>
+bool LevelGrid::overlapsWall(glm::vec3 pos, float halfSize) const {
+	//Walls sit on whole tile coordinates, so only those within halfSize on both axes can overlap
+	int minX = (int)ceil(pos.x - halfSize);
+	int maxX = (int)floor(pos.x + halfSize);
+	int minZ = (int)ceil(pos.z - halfSize);
+	int maxZ = (int)floor(pos.z + halfSize);
+
+	for (int x = minX; x <= maxX; x++) {
+		for (int z = minZ; z <= maxZ; z++) {
+			if (isWall(x, z)) return true;
+		}
+	}
+	return false;
+}
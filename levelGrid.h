@@ -0,0 +1,57 @@
+#ifndef LevelGrid_header
+#define LevelGrid_header
+
+#include <vector>
+#include "glm/glm/glm.hpp"
+
+using namespace std;
+
+/// <summary>
+/// Read only view of a level grid. Small enough to copy into every agent,
+/// all views share the tile storage of the grid they came from.
+/// </summary>
+struct LevelView {
+	const unsigned char* tiles = nullptr;
+	int sizeX = 0;
+	int sizeZ = 0;
+
+	/// <summary>
+	/// Checks if a tile can be walked on, everything outside of the level is blocked
+	/// </summary>
+	bool isOpen(int x, int z) const {
+		if (x < 0 || z < 0 || x >= sizeX || z >= sizeZ) return false;
+		return tiles[(size_t)x * sizeZ + z] == 0;
+	}
+};
+
+/// <summary>
+/// Tile occupancy of a level, one byte per tile, rows (world x) after each other.
+/// Tile (x, z) is the wall segment drawn at world position (x, 0, z).
+/// </summary>
+class LevelGrid {
+private:
+	int sizeX = 0;
+	int sizeZ = 0;
+	vector<unsigned char> tiles;
+
+public:
+	LevelGrid() = default;
+	LevelGrid(int _sizeX, int _sizeZ);
+
+	void setWall(int x, int z, bool wall);
+	bool overlapsWall(glm::vec3 pos, float halfSize) const;
+
+	LevelView view() const { return LevelView{ tiles.data(), sizeX, sizeZ }; }
+	int getSizeX() const { return sizeX; }
+	int getSizeZ() const { return sizeZ; }
+
+	/// <summary>
+	/// Checks a single tile, everything outside of the level counts as open
+	/// </summary>
+	bool isWall(int x, int z) const {
+		if (x < 0 || z < 0 || x >= sizeX || z >= sizeZ) return false;
+		return tiles[(size_t)x * sizeZ + z] != 0;
+	}
+};
+
+#endif
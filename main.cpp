@@ -3,6 +3,8 @@
 #include <fstream>
 #include <vector>
 #include <set>
+#include <chrono>
+#include <cstring>
 
 // Texture loader
 #define STB_IMAGE_IMPLEMENTATION
@@ -10,83 +12,220 @@
 
 //LearnOPENGL.com header files
 #include "learnopengl/shader_m.h"
-#include "learnopengl/filesystem.h"
 
 //Custom classes etc
-#include "ghost.h"
-#include "player.h"
+#include "world.h"
 #include "vaoHandler.h"
+#include "meshArena.h"
+#include "ringBuffer.h"
+#include "textureLoader.h"
+#include "chunkCulling.h"
+#include "visibilitySet.h"
+#include "assetPack.h"
 
 using namespace std;
 
 //Methods
-unsigned int initializeTexture(string path);
-void drawElements(vector<glm::vec3> elements, unsigned int texture, GLuint VAO, float scale, int vectorSize, Shader mainShader);
+int addLodCommands(DrawElementsIndirectCommand* commands, Instance* instances, GLuint baseInstance, ArenaMesh model,
+	const vector<MeshLod>& lods, const vector<glm::vec3>& positions, size_t capacity, float scale, glm::vec3 eye);
+int addWallCommands(DrawElementsIndirectCommand* commands, ArenaMesh walls, const WallMesh& mesh, const ChunkCulling& culling, GLuint baseInstance);
+void showCullingStats(const World& world, const ChunkCulling& culling, size_t pellets, size_t ghosts);
 void mouseCallback(GLFWwindow* window, double xpos, double ypos);
-void readLevel(string path);
+PlayerInput readInput(GLFWwindow* window);
+int runHeadless(World& world, int ticks);
 int initialize();
 
-//World variables
-vector<glm::vec3> level;
-vector<glm::vec3> pellets;
-vector<vector<int>> ghostLvl;
-vector<Ghost*> ghosts;
-vector<glm::vec3> ghostPos;
-Player* player;
-
 //Game logic variables
 float deltaTime = 0.0f;	// Time between current frame and last frame
 float lastFrame = 0.0f; // Time of last frame
-bool win = false;
-bool gameOver = false;
+
+//Asset names are relative to the project root, loose files are looked up there
+const string projectRoot = "../../../";
+const string defaultLevel = "levels/level0";
+const string defaultBinaryLevel = "levels/level0.lvl";
 
 //Screen
 const float WIDTH = 1920;
 const float HEIGHT = 1080;
 GLFWwindow* window;
 
-int main() {
+int main(int argc, char** argv) {
+	string levelPath;   // a loose level file, the default level comes from the asset pack
+	string packPath = projectRoot + "assets.pak";
+	int headlessTicks = -1;
+	float tickRate = 60.0f;
+	int maxCatchUp = 5;
+	int ghostCount = 4;
+	float chaseFraction = 0.25f;
+	int threadCount = (int)thread::hardware_concurrency();
+	uint64_t seed = (uint64_t)chrono::steady_clock::now().time_since_epoch().count();
+	bool pvsCache = true;
+
+	//Command line: [--level <path>] [--pack <path>] [--headless <ticks>] [--hz <rate>] [--max-steps <n>] [--ghosts <n>] [--chase <fraction>] [--threads <n>] [--seed <n>] [--no-pvs-cache]
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--level") == 0 && i + 1 < argc) {
+			levelPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--pack") == 0 && i + 1 < argc) {
+			packPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--headless") == 0 && i + 1 < argc) {
+			headlessTicks = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--hz") == 0 && i + 1 < argc) {
+			tickRate = (float)atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--max-steps") == 0 && i + 1 < argc) {
+			maxCatchUp = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--ghosts") == 0 && i + 1 < argc) {
+			ghostCount = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--chase") == 0 && i + 1 < argc) {
+			chaseFraction = (float)atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+			threadCount = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+			seed = strtoull(argv[++i], nullptr, 10);
+		}
+		else if (strcmp(argv[i], "--no-pvs-cache") == 0) {
+			pvsCache = false;
+		}
+		else {
+			cerr << "Usage: " << argv[0] << " [--level <path>] [--pack <path>] [--headless <ticks>] [--hz <rate>] [--max-steps <n>] [--ghosts <n>] [--chase <fraction>] [--threads <n>] [--seed <n>] [--no-pvs-cache]" << endl;
+			return EXIT_FAILURE;
+		}
+	}
 
-	readLevel("../../../levels/level0");
+	if (tickRate <= 0 || maxCatchUp < 1) {
+		cerr << "Tick rate and max steps must be positive" << endl;
+		return EXIT_FAILURE;
+	}
+
+	//Printed so any run can be replayed with --seed
+	cout << "seed: " << seed << endl;
+
+	//Shaders, textures, models and the level come from one mapped pack, or from loose files without one
+	AssetPack assets(packPath, projectRoot);
+	if (assets.isPacked()) cout << "Asset pack " << packPath << ": " << assets.getEntryCount() << " assets" << endl;
+	//The binary level converted from the default level is used when there is one
+	Asset levelFile = levelPath.empty() ? assets.open(defaultBinaryLevel) : AssetPack::openFile(levelPath);
+	if (levelPath.empty() && !levelFile.isOpen()) levelFile = assets.open(defaultLevel);
+	if (levelPath.empty()) levelPath = assets.loosePath(defaultLevel);
+
+	JobSystem jobs(threadCount);
+	World world(seed);
+	if (!levelFile.isOpen()) {
+		cout << "\n --Unable to read file " << levelPath;
+		return EXIT_FAILURE;
+	}
+	if (!world.readLevel(levelFile, ghostCount, chaseFraction)) {
+		return EXIT_FAILURE;
+	}
+	world.setTickRate(tickRate, maxCatchUp);
+	world.setJobSystem(&jobs);
+
+	//No window or GL context, just run the simulation
+	if (headlessTicks >= 0) {
+		return runHeadless(world, headlessTicks);
+	}
 
 	//initalizes all the libraries used
 	if (initialize() == EXIT_FAILURE) {
 		return EXIT_FAILURE;
 	}
 
-	// build and compile our shader program
-	Shader ourShader("../../../shaders/7.1.camera.vs", "../../../shaders/7.1.camera.frag");
+	Asset vertexShader = assets.open("shaders/7.1.camera.vs"), fragmentShader = assets.open("shaders/7.1.camera.frag");
+	if (!vertexShader.isOpen() || !fragmentShader.isOpen()) {
+		cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << endl;
+		glfwTerminate();
+		return EXIT_FAILURE;
+	}
 
-	// load and create a texture from path
-	unsigned int wallTexture = initializeTexture("../../../../resources/textures/wall.jpg");
-	unsigned int pelletTexture = initializeTexture("../../../../resources/textures/yellow.jpg");
-	unsigned int ghostTexture = initializeTexture("../../../../resources/textures/tex.jpg");
+	// load and create the textures from path, one layer each: walls, pellets, ghosts.
+	// They are decoded on the job system while the rest of the startup runs, placeholders are drawn until then
+	TextureLoader textures(jobs, assets, { "resources/textures/wall.jpg", "resources/textures/yellow.jpg", "resources/textures/tex.jpg" });
+	auto sinceStartup = [&textures]() { return chrono::duration<double, milli>(chrono::steady_clock::now() - textures.getStart()).count(); };
 
-	//Loads in and creates VAO for all models
-	int pelletSize = 0, ghostSize = 0;
-	GLuint wallVAO = wallSegment();
-	GLuint pelletVAO = loadModel("../../../resources/model/pellets/", "globe-sphere.obj", pelletSize);
-	GLuint ghostVAO = loadModel("../../../resources/model/ghost/","pacman-ghosts.obj", ghostSize);
+	// build and compile our shader program
+	Shader ourShader((const char*)vertexShader.data, (GLint)vertexShader.size, (const char*)fragmentShader.data, (GLint)fragmentShader.size);
+	double shaderReady = sinceStartup();
+
+	//Loads all models and the baked walls into one vertex and index buffer
+	vector<MeshLod> pelletLods, ghostLods;
+	MeshArena arena;
+	ArenaMesh wallMesh = arena.addTriangles(world.getWallMesh().getVertices(), 0.0f);
+	ArenaMesh pelletMesh = loadModel(assets, "resources/model/pellets/", "globe-sphere.obj", arena, 1.0f, pelletLods);
+	ArenaMesh ghostMesh = loadModel(assets, "resources/model/ghost/", "pacman-ghosts.obj", arena, 2.0f, ghostLods);
+	arena.upload();
+	double modelsReady = sinceStartup();
+
+	//Only chunks of the level in front of the camera are drawn, same chunks as the wall mesh
+	const LevelGrid& grid = world.getLevelGrid();
+	ChunkCulling culling(grid.getSizeX(), grid.getSizeZ(), world.getWallMesh().getChunkSize(), -2.0f, 2.0f);
+	vector<glm::vec3> visiblePellets, visibleGhosts;
+
+	//Positions and scales of every copy of a model and the draw commands are written every frame straight
+	//into mapped memory, sized for everything being visible at once. The walls are a single baked mesh drawn
+	//as one instance, followed by room for all pellets and all ghosts.
+	size_t pelletCapacity = world.getPellets().size(), ghostCapacity = world.getGhostPositions().size();
+	RingBuffer instanceRing(GL_ARRAY_BUFFER, sizeof(Instance) * (1 + pelletCapacity + ghostCapacity));
+	RingBuffer commandRing(GL_DRAW_INDIRECT_BUFFER,
+		sizeof(DrawElementsIndirectCommand) * (culling.getChunkCount() + pelletLods.size() + ghostLods.size()));
+	arena.setInstanceBuffer(instanceRing.getBuffer());
+
+	//Chunks that can be seen from each tile, walls hide the rest of the maze. Building takes time in
+	//proportion to the number of tiles, so the sets are cached next to the level and huge levels without
+	//a cache only cull by the view.
+	const float farPlane = 100.0f;
+	const size_t maxPvsTiles = 2049 * 2049;
+	VisibilitySet pvs;
+	string pvsPath = levelPath + ".pvs";
+	if (pvsCache && pvs.load(pvsPath, grid.view(), culling.getChunkSize(), farPlane)) {
+		cout << "Visibility sets loaded from " << pvsPath << endl;
+	}
+	else if ((size_t)grid.getSizeX() * grid.getSizeZ() > maxPvsTiles) {
+		cout << "Level too large to build visibility sets at startup, culling by the view only" << endl;
+	}
+	else {
+		auto start = chrono::steady_clock::now();
+		pvs = VisibilitySet(grid.view(), culling.getChunkSize(), farPlane, &jobs);
+		chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+		cout << "Visibility sets built in " << elapsed.count() * 1000 << " ms, " << pvs.getSetCount() << " sets in "
+			<< pvs.getMemoryUsage() / 1024 << " KB" << endl;
+		if (pvsCache) pvs.save(pvsPath);
+	}
+	double visibilityReady = sinceStartup();
+	double firstFrame = -1.0;
+	float lastStats = 0.0f;
+
+	cout << "Draw calls per frame: 1 multi draw, one per object would be "
+		<< world.getWalls().size() + world.getPellets().size() + world.getGhostPositions().size() << endl;
+	cout << "Wall triangles: " << world.getWallMesh().getTriangleCount() << " baked, "
+		<< world.getWalls().size() * 8 << " as separate segments" << endl;
 
 	// tell opengl for each sampler to which texture unit it belongs to (only has to be done once)
 	ourShader.use();
-	ourShader.setInt("texture", 0);
+	ourShader.setInt("texture1", 0);
 
-	// set lightning data for the shader
-	ourShader.setVec3("light.Direction", -5.f, -3.f, -1.f);
-	ourShader.setVec3("light.ambient", 1.f, 1.f, 1.f);
-	ourShader.setVec3("light.diffuse", 10.f, 10.f, 10.f);
-	ourShader.setVec3("light.specular", 15.0f, 15.0f, 15.0f);
-
-	// pass projection matrix to shader (as projection matrix rarely changes there's no need to do this per frame)
-	glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)WIDTH / (float)HEIGHT, 0.1f, 100.0f);
-	ourShader.setMat4("projection", projection);
+	// per-frame data (camera and lightning) is shared by all shaders through one uniform buffer
+	FrameUniformBuffer frameBuffer;
+	FrameUniforms frame;
+	frame.light.direction = glm::vec3(-5.f, -3.f, -1.f);
+	frame.light.ambient = glm::vec3(1.f, 1.f, 1.f);
+	frame.light.diffuse = glm::vec3(10.f, 10.f, 10.f);
+	frame.light.specular = glm::vec3(15.0f, 15.0f, 15.0f);
+	frame.projection = glm::perspective(glm::radians(45.0f), (float)WIDTH / (float)HEIGHT, 0.1f, farPlane);
 
 	//Input configuration && callback method
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	glfwSetWindowUserPointer(window, &world);
 	glfwSetCursorPosCallback(window, mouseCallback);
 
-	for (int i = 0; i < 4; i++) { ghostPos.push_back(glm::vec3(0, 0, 0)); } // Initialize ghost position vector
+	Player* player = world.getPlayer();
+	vector<uint32_t> visibleObjects;
 	//Main game loop
 	while(!glfwWindowShouldClose(window)){
 
@@ -100,29 +239,10 @@ int main() {
 		lastFrame = currentFrame;
 
 		//moving lights
-		ourShader.setVec3("light.Direction", -1.f * (cos(currentFrame)/2), -2 * abs(sin((currentFrame/3))), -1.0f *(sin(currentFrame/2 + 0.5)));
-
-		//pellet logic
-		for (int i = 0; i < pellets.size(); i++) {
-			//If pellets withing pickup range of player: remove it from vector
-			if (glm::distance(pellets[i], player->getPosition()) < 0.5f) pellets.erase(pellets.begin()+i);
-		}
-		if (pellets.size() == 0) { //win condition
-			win = true;
-			cout << "YOU WIN!" << endl;
-		}
-
-		//ghost logic
-		for (int i = 0; i < ghosts.size(); i++) {
-			ghostPos[i] = ghosts[i]->updateGhost(deltaTime); //update ghosts Position and return it to position-array
-			if (glm::distance(ghostPos[i], player->getPosition()) < 1.0f) { //If current ghost within range of player, Game Over!
-				gameOver = true; 
-				cout << "YOU LOSE" << endl;
-			}
-		}
+		frame.light.direction = glm::vec3(-1.f * (cos(currentFrame)/2), -2 * abs(sin((currentFrame/3))), -1.0f *(sin(currentFrame/2 + 0.5)));
 
-		//userInput
-		player->processInput(window, deltaTime);
+		//pellets, ghosts and userInput, run at a fixed rate
+		world.update(deltaTime, readInput(window));
 
 		//##########################################################
 		// DRAW PORTION
@@ -130,88 +250,225 @@ int main() {
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		// activate shader and apply player view
-		ourShader.use();
-		ourShader.setMat4("view", player->generateView());
+		// render in between the last two simulation steps
+		glm::vec3 eye = world.getInterpolatedPlayerPosition();
 
-		// give camera position for specular light calculation
-		ourShader.setVec3("CameraPosition", player->getPosition());
+		// apply player view and give camera position for specular light calculation, all in one buffer update
+		bool gameDone = world.hasWon() || world.isGameOver();
+		frame.view = gameDone ? glm::mat4(1.0f) : player->generateView(eye);
+		frame.cameraPosition = eye;
+		frameBuffer.update(frame);
+		ourShader.use();
 		
-		//Draw walls, pellets and ghosts
-		drawElements(level, wallTexture, wallVAO, 1.0f , 36, ourShader);
-		drawElements(pellets, pelletTexture, pelletVAO, 0.3f, pelletSize, ourShader);
-		drawElements(ghostPos, ghostTexture, ghostVAO, 0.75f, ghostSize, ourShader);
+		//Leave out everything in chunks outside the view or hidden behind walls from the player's tile,
+		//pellets and ghosts are collected from the buckets of the visible chunks only
+		int pvsCount = 0;
+		const uint32_t* pvsChunks = pvs.getChunks((int)floor(eye.x + 0.5f), (int)floor(eye.z + 0.5f), pvsCount);
+		if (pvsCount > 0 && !gameDone) culling.update(Frustum(frame.projection * frame.view), pvsChunks, pvsCount);
+		else culling.update(Frustum(frame.projection * frame.view));
+		world.getPelletChunks().collect(culling.getVisibleChunks(), visibleObjects);
+		world.getPelletPositions(visibleObjects, visiblePellets);
+		world.getGhostChunks().collect(culling.getVisibleChunks(), visibleObjects);
+		world.getInterpolatedGhostPositions(visibleObjects, visibleGhosts);
+
+		//One draw command per visible range of walls and per level of detail of pellets and ghosts in use,
+		//far away models with fewer triangles
+		Instance* instances = (Instance*)instanceRing.map(instanceRing.getRegionSize());
+		DrawElementsIndirectCommand* commands = (DrawElementsIndirectCommand*)commandRing.map(commandRing.getRegionSize());
+		GLuint baseInstance = (GLuint)(instanceRing.getOffset() / sizeof(Instance));
+		instances[0] = Instance{ glm::vec3(0.0f), 1.0f }; // walls are baked in world space
+		int commandCount = addWallCommands(commands, wallMesh, world.getWallMesh(), culling, baseInstance);
+		commandCount += addLodCommands(commands + commandCount, instances + 1, baseInstance + 1,
+			pelletMesh, pelletLods, visiblePellets, pelletCapacity, 0.3f, eye);
+		commandCount += addLodCommands(commands + commandCount, instances + 1 + pelletCapacity, baseInstance + 1 + (GLuint)pelletCapacity,
+			ghostMesh, ghostLods, visibleGhosts, ghostCapacity, 0.75f, eye);
+		instanceRing.unmap();
+		commandRing.unmap();
+
+		//Draw walls, pellets and ghosts in one call
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, textures.getTexture());
+		glBindVertexArray(arena.getVAO());
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandRing.getBuffer());
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)commandRing.getOffset(), commandCount, 0);
+
+		//The regions may be written again once this draw is done
+		instanceRing.fence();
+		commandRing.fence();
+
+		//Visible and total counts in the title bar for profiling
+		if (currentFrame - lastStats >= 0.5f) {
+			lastStats = currentFrame;
+			showCullingStats(world, culling, visiblePellets.size(), visibleGhosts.size());
+		}
+
+		//Hand decoded textures to GL, the startup timeline is printed once all of them are in
+		if (firstFrame < 0) firstFrame = sinceStartup();
+		if (textures.update()) {
+			cout << "Startup timeline (ms): shader compiled " << shaderReady << ", models loaded " << modelsReady
+				<< ", visibility sets " << visibilityReady << ", first frame " << firstFrame << ", textures complete " << sinceStartup() << endl;
+			textures.printTimeline(cout);
+		}
 
 		glfwSwapBuffers(window);
 		glfwPollEvents();
 	}
 
 	//Termination of Stuff 
-	cleanVAO(ghostVAO);
-	cleanVAO(pelletVAO);
-	cleanVAO(wallVAO);
+	arena.destroy();
+	commandRing.destroy();
+	instanceRing.destroy();
+	textures.destroy();
+	glDeleteBuffers(1, &frameBuffer.ID);
 	glfwTerminate();
 }
 
+//Distance from the camera at which instances switch to the next level of detail
+const float lodDistances[] = { 8.0f, 20.0f };
+
+/// <summary>
+/// Writes the instances of a model grouped by level of detail, picked for each by its distance to the
+/// camera, and one draw command per level in use
+/// </summary>
+/// <param name="commands">Where to write the draw commands, room for one per level</param>
+/// <param name="instances">Where to write the instances, room for capacity</param>
+/// <param name="baseInstance">Index of instances[0] in the instance buffer</param>
+/// <param name="model">Where the model is in the arena</param>
+/// <param name="lods">Index ranges made by loadModel, full detail first</param>
+/// <param name="positions">Position of every instance</param>
+/// <param name="capacity">Most instances that may be written</param>
+/// <param name="scale">Scale shared by all instances</param>
+/// <param name="eye">Camera position</param>
+/// <returns>Number of draw commands written</returns>
+int addLodCommands(DrawElementsIndirectCommand* commands, Instance* instances, GLuint baseInstance, ArenaMesh model,
+	const vector<MeshLod>& lods, const vector<glm::vec3>& positions, size_t capacity, float scale, glm::vec3 eye) {
+	static vector<unsigned char> levels;
+	size_t count = min(positions.size(), capacity);
+	if (count == 0 || lods.empty()) return 0;
+
+	//Counting sort by level, the squared distance is enough to compare
+	int levelCount = min((int)lods.size(), (int)(sizeof(lodDistances) / sizeof(lodDistances[0])) + 1);
+	int counts[8] = {};
+	levels.resize(count);
+	for (size_t i = 0; i < count; i++) {
+		glm::vec3 offset = positions[i] - eye;
+		float distance = glm::dot(offset, offset);
+		int level = 0;
+		while (level + 1 < levelCount && distance > lodDistances[level] * lodDistances[level]) level++;
+		levels[i] = (unsigned char)level;
+		counts[level]++;
+	}
+	int firsts[8] = {};
+	for (int level = 1; level < levelCount; level++) firsts[level] = firsts[level - 1] + counts[level - 1];
+
+	int next[8];
+	memcpy(next, firsts, sizeof(next));
+	for (size_t i = 0; i < count; i++) instances[next[levels[i]]++] = Instance{ positions[i], scale };
+
+	int commandCount = 0;
+	for (int level = 0; level < levelCount; level++) {
+		if (counts[level] == 0) continue;
+		const MeshLod& lod = lods[level];
+		commands[commandCount++] = DrawElementsIndirectCommand{ (GLuint)lod.indexCount, (GLuint)counts[level],
+			(GLuint)(model.firstIndex + lod.firstIndex), model.baseVertex, baseInstance + firsts[level] };
+	}
+	return commandCount;
+}
+
 /// <summary>
-/// Draws a VAO at an array of positions, with texture and scale
+/// Writes draw commands for the chunks of the wall mesh that are visible, neighbouring chunks as one range
 /// </summary>
-/// <param name="elements">Positions to draw VAOs at</param>
-/// <param name="texture">Texture applied to VAOs</param>
-/// <param name="VAO">VAO to draw</param>
-/// <param name="scale">Scale to draw VAOs in</param>
-/// <param name="vectorSize">Number of vertices in VAO</param>
-/// <param name="mainShader">ShaderProgram</param>
-void drawElements(vector<glm::vec3> elements, unsigned int texture, GLuint VAO, float scale, int vectorSize, Shader shader) {
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, texture);
-	glBindVertexArray(VAO);
-	for (int i = 0; i < elements.size(); i++) {
-		glm::mat4 model = glm::mat4(1.0f);
-		model = glm::translate(model, elements[i]);
-		model = glm::scale(model, glm::vec3(scale, scale, scale));
-		shader.setMat4("model", model);
-		glDrawArrays(GL_TRIANGLES, 0, vectorSize);
+/// <param name="commands">Where to write the draw commands, room for one per chunk</param>
+/// <param name="walls">Where the wall mesh is in the arena</param>
+/// <param name="mesh">Wall mesh, chunked like culling</param>
+/// <param name="culling">Chunks visible this frame</param>
+/// <param name="baseInstance">Instance holding the walls' position and scale</param>
+/// <returns>Number of draw commands written</returns>
+int addWallCommands(DrawElementsIndirectCommand* commands, ArenaMesh walls, const WallMesh& mesh, const ChunkCulling& culling, GLuint baseInstance) {
+	//Ranges are joined before they are written, the mapped commands are never read back
+	int commandCount = 0;
+	int first = 0, count = 0;
+	for (int c : culling.getVisibleChunks()) {
+		int chunkCount = mesh.getChunkVertexCount(c);
+		if (chunkCount == 0) continue;
+		if (count > 0 && first + count == mesh.getChunkFirst(c)) {
+			count += chunkCount;
+			continue;
+		}
+		if (count > 0) {
+			commands[commandCount++] = DrawElementsIndirectCommand{ (GLuint)count, 1, (GLuint)(walls.firstIndex + first), walls.baseVertex, baseInstance };
+		}
+		first = mesh.getChunkFirst(c);
+		count = chunkCount;
+	}
+	if (count > 0) {
+		commands[commandCount++] = DrawElementsIndirectCommand{ (GLuint)count, 1, (GLuint)(walls.firstIndex + first), walls.baseVertex, baseInstance };
 	}
+	return commandCount;
+}
+
+/// <summary>
+/// Shows how much of the level survived culling in the window title
+/// </summary>
+/// <param name="world">World being drawn</param>
+/// <param name="culling">Chunks visible this frame</param>
+/// <param name="pellets">Pellets drawn</param>
+/// <param name="ghosts">Ghosts drawn</param>
+void showCullingStats(const World& world, const ChunkCulling& culling, size_t pellets, size_t ghosts) {
+	string title = "Pacman3D | chunks " + to_string(culling.getVisibleCount()) + "/" + to_string(culling.getChunkCount())
+		+ " | pellets " + to_string(pellets) + "/" + to_string(world.getPellets().size())
+		+ " | ghosts " + to_string(ghosts) + "/" + to_string(world.getGhostPositions().size());
+	glfwSetWindowTitle(window, title.c_str());
 }
 
 //Calls the same function in Player class as i couldnt apply the class function directly
 void mouseCallback(GLFWwindow* window, double xpos, double ypos)
 {
-	player->mouseCallback(window, xpos, ypos);
+	World* world = (World*)glfwGetWindowUserPointer(window);
+	world->getPlayer()->mouseCallback(xpos, ypos);
 }
 
 /// <summary>
-/// Loads texture from path and returns it
+/// Reads movement keys from the window and handles the close key
 /// </summary>
-/// <param name="path"> path to texture</param>
-/// <returns>texture</returns>
-unsigned int initializeTexture(string path) {
-	unsigned int texture;
-
-	glGenTextures(1, &texture);
-	glBindTexture(GL_TEXTURE_2D, texture);
-	// set the texture wrapping parameters
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	// set texture filtering parameters
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	// load image, create texture and generate mipmaps
-	int width, height, nrChannels;
-	//stbi_set_flip_vertically_on_load(true); // tell stb_image.h to flip loaded texture's on the y-axis.
-	unsigned char* data = stbi_load(FileSystem::getPath(path).c_str(), &width, &height, &nrChannels, 0);
-	if (data)
-	{
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
-	}
-	else
-	{
-		std::cout << "Failed to load texture from " << path << std::endl;
+/// <param name="window">Window to get input data from</param>
+/// <returns>Keys held this frame</returns>
+PlayerInput readInput(GLFWwindow* window) {
+	//Close window
+	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+		glfwSetWindowShouldClose(window, true);
+
+	PlayerInput input;
+	input.forward = glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS;
+	input.back = glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS;
+	input.left = glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS;
+	input.right = glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS;
+	return input;
+}
+
+/// <summary>
+/// Runs the simulation without a window or GL context and reports its speed
+/// </summary>
+/// <param name="world">Loaded world to simulate</param>
+/// <param name="ticks">Number of steps to run</param>
+/// <returns>success code</returns>
+int runHeadless(World& world, int ticks) {
+	const float dt = world.getStepTime();
+	PlayerInput idle;
+
+	auto start = chrono::steady_clock::now();
+	for (int i = 0; i < ticks; i++) {
+		world.step(dt, idle);
 	}
-	stbi_image_free(data);
-	return texture;
+	chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+	cout << ticks << " ticks in " << elapsed.count() << " s";
+	if (elapsed.count() > 0) cout << " (" << ticks / elapsed.count() << " ticks/s)";
+	cout << endl;
+	cout << "pellets left: " << world.getPelletCount()
+		<< ", win: " << world.hasWon() << ", game over: " << world.isGameOver() << endl;
+	cout << "state hash: " << hex << world.stateHash() << dec << endl;
+	return 0;
 }
 
 /// <summary>
@@ -260,61 +517,3 @@ int initialize() {
 	//Nothing went wrong
 	return 0;
 }
-
-/// <summary>
-/// Loads in a level from file and initializes Player and Ghosts
-/// </summary>
-/// <param name="path"></param>
-void readLevel(string path) {
-	ifstream lvlFile(path);
-	if (lvlFile)
-	{
-		string size;
-		lvlFile >> size;
-		int xMax = stoi(size.substr(0, 2));
-		int yMax = stoi(size.substr(3));
-
-		//init 2D Vector
-		ghostLvl = vector<vector<int>>(xMax);
-		for (int i = 0; i < xMax; i++) {
-			ghostLvl[i] = vector<int>(yMax);
-		}
-
-		int data;
-
-		// read current level
-		cout << xMax << "*" << yMax << endl;
-		for (int i = 0; i < yMax; i++) {
-			for (int j = 0; j < xMax; j++) {
-				lvlFile >> data;
-				switch (data) {
-				case 0:
-					pellets.push_back(glm::vec3(i, -0.25, j));
-					break;
-				case 1:
-					level.push_back(glm::vec3(i, 0, j));
-					break;
-				case 2:
-					player = new Player(glm::vec3(i, 0, j), WIDTH / 2, HEIGHT / 2);
-					break;
-				}
-				ghostLvl[j][i] = (data == 1) ? 1 : 0; // Build level for ghost AI
-			}
-		}
-
-		//Generate ghost position
-		//RNG seeded by current time in seconds since January 1st, 1970
-		srand(time(NULL));
-		for (int i = 0; i < 4; i++) {
-			//Pellets contain all walkable space in map so a random pick from pellets will give a valid location
-			glm::vec3 pos = pellets[rand() % pellets.size()];
-			ghosts.push_back(new Ghost(ghostLvl, pos.z, pos.x));
-			
-			srand(rand()); //re-seed rng
-		}
-	}
-	else {
-		cout << "\n --Unable to read file " << path;
-	}
-	lvlFile.close();
-}
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "mappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/// <summary>
+/// Maps a file. Missing and empty files leave the object closed.
+/// </summary>
+/// <param name="path">File to map</param>
+MappedFile::MappedFile(const string& path) {
+#ifdef _WIN32
+	HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE) return;
+	file = handle;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(handle, &fileSize) || fileSize.QuadPart == 0) {
+		close();
+		return;
+	}
+	mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping) {
+		close();
+		return;
+	}
+	bytes = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!bytes) {
+		close();
+		return;
+	}
+	length = (size_t)fileSize.QuadPart;
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) return;
+
+	//The mapping keeps the file alive, the descriptor is not needed after this
+	struct stat info;
+	if (fstat(fd, &info) == 0 && info.st_size > 0) {
+		void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (view != MAP_FAILED) {
+			bytes = (const unsigned char*)view;
+			length = (size_t)info.st_size;
+		}
+	}
+	::close(fd);
+#endif
+}
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+/// <summary>
+/// Ends the mapping early, e.g. to overwrite the file
+/// </summary>
+void MappedFile::close() {
+#ifdef _WIN32
+	if (bytes) UnmapViewOfFile(bytes);
+	if (mapping) CloseHandle(mapping);
+	if (file) CloseHandle(file);
+	mapping = nullptr;
+	file = nullptr;
+#else
+	if (bytes) munmap((void*)bytes, length);
+#endif
+	bytes = nullptr;
+	length = 0;
+}
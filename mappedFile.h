@@ -0,0 +1,36 @@
+#ifndef MappedFile_header
+#define MappedFile_header
+
+#include <string>
+#include <cstddef>
+
+using namespace std;
+
+/// <summary>
+/// A whole file mapped read only into memory. The operating system pages it in on first
+/// access, so nothing is read or copied up front. The mapping ends with the object.
+/// </summary>
+class MappedFile {
+private:
+	const unsigned char* bytes = nullptr;
+	size_t length = 0;
+#ifdef _WIN32
+	void* file = nullptr;
+	void* mapping = nullptr;
+#endif
+
+public:
+	MappedFile() = default;
+	MappedFile(const string& path);
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	void close();
+
+	bool isOpen() const { return bytes != nullptr; }
+	const unsigned char* data() const { return bytes; }
+	size_t size() const { return length; }
+};
+
+#endif
@@ -0,0 +1,101 @@
+#include "meshArena.h"
+
+#include <cstddef>
+
+/// <summary>
+/// Appends an indexed model mesh, all its levels of detail included
+/// </summary>
+/// <param name="meshVertices">Vertices of the mesh</param>
+/// <param name="vertexCount">Number of vertices</param>
+/// <param name="meshIndices">Indices of the mesh, counting from its first vertex</param>
+/// <param name="indexCount">Number of indices</param>
+/// <param name="layer">Texture array layer of the mesh</param>
+/// <returns>Offsets to add to the mesh's index ranges</returns>
+ArenaMesh MeshArena::addMesh(const Vertex* meshVertices, size_t vertexCount, const uint32_t* meshIndices, size_t indexCount, float layer) {
+	ArenaMesh placed{ (int)indices.size(), (int)vertices.size() };
+	vertices.reserve(vertices.size() + vertexCount);
+	for (size_t i = 0; i < vertexCount; i++) {
+		const Vertex& vertex = meshVertices[i];
+		vertices.push_back(SceneVertex{ vertex.location, vertex.texCoords, vertex.normals, layer });
+	}
+	indices.insert(indices.end(), meshIndices, meshIndices + indexCount);
+	return placed;
+}
+
+/// <summary>
+/// Appends a triangle list laid out like the wall mesh. Every vertex gets its own index,
+/// so a range of vertices is drawn as the same range of indices.
+/// </summary>
+/// <param name="triangles">8 floats per vertex: position, texture coordinate and normal</param>
+/// <param name="layer">Texture array layer of the mesh</param>
+/// <returns>Offsets to add to the vertex ranges</returns>
+ArenaMesh MeshArena::addTriangles(const vector<float>& triangles, float layer) {
+	ArenaMesh placed{ (int)indices.size(), (int)vertices.size() };
+	uint32_t count = (uint32_t)(triangles.size() / 8);
+	for (uint32_t i = 0; i < count; i++) {
+		const float* v = &triangles[(size_t)i * 8];
+		vertices.push_back(SceneVertex{ glm::vec3(v[0], v[1], v[2]), glm::vec2(v[3], v[4]), glm::vec3(v[5], v[6], v[7]), layer });
+		indices.push_back(i);
+	}
+	return placed;
+}
+
+/// <summary>
+/// Creates the VAO with the vertex and index buffers of everything added so far
+/// </summary>
+/// <returns>New VAO</returns>
+GLuint MeshArena::upload() {
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+
+	glGenBuffers(1, &vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(SceneVertex) * vertices.size(), vertices.data(), GL_STATIC_DRAW);
+
+	glGenBuffers(1, &ebo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint32_t) * indices.size(), indices.data(), GL_STATIC_DRAW);
+
+	// position attribute
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(SceneVertex), (void*)offsetof(SceneVertex, position));
+	glEnableVertexAttribArray(0);
+	// texture coord attribute
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(SceneVertex), (void*)offsetof(SceneVertex, texCoord));
+	glEnableVertexAttribArray(1);
+	// normal attribute
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(SceneVertex), (void*)offsetof(SceneVertex, normal));
+	glEnableVertexAttribArray(2);
+	// texture layer attribute
+	glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(SceneVertex), (void*)offsetof(SceneVertex, layer));
+	glEnableVertexAttribArray(4);
+
+	glBindVertexArray(0);
+	return vao;
+}
+
+/// <summary>
+/// Makes a buffer of per instance positions and scales attribute 3, read once per instance.
+/// Draw commands select their instances with the base instance.
+/// </summary>
+/// <param name="buffer">Buffer holding Instance entries</param>
+void MeshArena::setInstanceBuffer(GLuint buffer) {
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+	// position and scale attribute, advances once per instance instead of once per vertex
+	glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)0);
+	glEnableVertexAttribArray(3);
+	glVertexAttribDivisor(3, 1);
+
+	glBindVertexArray(0);
+}
+
+/// <summary>
+/// Deletes the VAO and its vertex and index buffers
+/// </summary>
+void MeshArena::destroy() {
+	glDeleteVertexArrays(1, &vao);
+	glDeleteBuffers(1, &vbo);
+	glDeleteBuffers(1, &ebo);
+	vao = vbo = ebo = 0;
+}
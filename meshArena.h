@@ -0,0 +1,68 @@
+#ifndef MeshArena_header
+#define MeshArena_header
+
+#include <glad/glad.h>
+#include <vector>
+#include <cstdint>
+#include "glm/glm/glm.hpp"
+#include "indexedMesh.h"
+
+using namespace std;
+
+//Per instance data read by the vertex shader, one for every copy of a mesh that is drawn
+struct Instance
+{
+	glm::vec3 position;
+	float scale;
+};
+
+//Vertex of every mesh in the arena, the layer picks the mesh's texture in the texture array
+struct SceneVertex
+{
+	glm::vec3 position;
+	glm::vec2 texCoord;
+	glm::vec3 normal;
+	float layer;
+};
+
+//Layout glMultiDrawElementsIndirect reads from the indirect buffer
+struct DrawElementsIndirectCommand
+{
+	GLuint count;
+	GLuint instanceCount;
+	GLuint firstIndex;
+	GLint baseVertex;
+	GLuint baseInstance;
+};
+
+//Where a mesh ended up in the arena, its indices count from its first vertex
+struct ArenaMesh
+{
+	int firstIndex;
+	int baseVertex;
+};
+
+/// <summary>
+/// Every mesh of the scene in one vertex buffer and one index buffer behind a single VAO,
+/// so all of them can be drawn with one multi draw call. Meshes are added first, then uploaded once.
+/// </summary>
+class MeshArena {
+private:
+	vector<SceneVertex> vertices;
+	vector<uint32_t> indices;
+	GLuint vao = 0, vbo = 0, ebo = 0;
+
+public:
+	ArenaMesh addMesh(const Vertex* meshVertices, size_t vertexCount, const uint32_t* meshIndices, size_t indexCount, float layer);
+	ArenaMesh addTriangles(const vector<float>& triangles, float layer);
+
+	GLuint upload();
+	void setInstanceBuffer(GLuint buffer);
+	void destroy();
+
+	GLuint getVAO() const { return vao; }
+	size_t getVertexCount() const { return vertices.size(); }
+	size_t getIndexCount() const { return indices.size(); }
+};
+
+#endif
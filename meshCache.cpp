@@ -0,0 +1,108 @@
+#include "meshCache.h"
+
+#include <fstream>
+#include <iostream>
+#include <cstring>
+
+//Layout of a mesh cache file: the header, then the vertices, the indices of every level of detail
+//and the level table, each tightly packed and 4 byte aligned so they can be used in place
+const uint32_t meshCacheMagic = 0x3148534D; // "MSH1"
+struct MeshCacheHeader {
+	uint32_t magic;
+	uint32_t vertexSize;    // sizeof(Vertex) when written
+	uint64_t sourceHash;    // hashMeshSource of the model file
+	uint32_t vertexCount, indexCount, lodCount, reserved;
+	float boundsMin[3], boundsMax[3];
+};
+
+/// <summary>
+/// Hash of a model file continued with everything else that shapes the cached mesh,
+/// so changing the file or the level of detail targets makes old caches stale
+/// </summary>
+/// <param name="fileHash">hashBytes of the model file, e.g. Asset::getHash</param>
+uint64_t hashMeshSource(uint64_t fileHash) {
+	uint64_t hash = fileHash;
+	for (const LodTarget& target : modelLods) {
+		hash = hashBytes(&target.triangleFraction, sizeof(float), hash);
+		hash = hashBytes(&target.maxError, sizeof(float), hash);
+	}
+	return hash;
+}
+
+/// <summary>
+/// Writes a finished mesh and its levels of detail to a cache file
+/// </summary>
+/// <param name="path">File to write</param>
+/// <param name="sourceHash">hashMeshSource of the model file the mesh was built from</param>
+/// <param name="mesh">Mesh with all levels of detail in its indices</param>
+/// <param name="lods">Index ranges of the levels</param>
+/// <returns>false if the file could not be written</returns>
+bool writeMeshCache(const string& path, uint64_t sourceHash, const IndexedMesh& mesh, const vector<MeshLod>& lods) {
+	ofstream file(path, ios::binary);
+	if (!file) {
+		cout << "Unable to write mesh cache " << path << endl;
+		return false;
+	}
+
+	MeshCacheHeader header = { meshCacheMagic, sizeof(Vertex), sourceHash,
+		(uint32_t)mesh.vertices.size(), (uint32_t)mesh.indices.size(), (uint32_t)lods.size(), 0, {}, {} };
+	if (!mesh.vertices.empty()) {
+		glm::vec3 low = mesh.vertices[0].location, high = low;
+		for (const Vertex& vertex : mesh.vertices) {
+			low = glm::min(low, vertex.location);
+			high = glm::max(high, vertex.location);
+		}
+		for (int a = 0; a < 3; a++) {
+			header.boundsMin[a] = low[a];
+			header.boundsMax[a] = high[a];
+		}
+	}
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex));
+	file.write((const char*)mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+	file.write((const char*)lods.data(), lods.size() * sizeof(MeshLod));
+	return (bool)file;
+}
+
+/// <summary>
+/// Points a MeshData at the arrays inside a mapped cache file, if the file is complete and was
+/// written from the same source. Nothing is copied, the file must stay mapped while data is used.
+/// </summary>
+/// <param name="bytes">Mapped cache file, null if there is none</param>
+/// <param name="size">Size of the cache file</param>
+/// <param name="sourceHash">hashMeshSource of the current model file</param>
+/// <param name="data">Receives the mesh</param>
+/// <returns>false if the cache is missing, damaged or stale</returns>
+bool readMeshCache(const unsigned char* bytes, size_t size, uint64_t sourceHash, MeshData& data) {
+	if (!bytes || size < sizeof(MeshCacheHeader)) return false;
+
+	MeshCacheHeader header;
+	memcpy(&header, bytes, sizeof(header));
+	if (header.magic != meshCacheMagic || header.vertexSize != sizeof(Vertex) || header.sourceHash != sourceHash) return false;
+
+	size_t expected = sizeof(header) + (size_t)header.vertexCount * sizeof(Vertex)
+		+ (size_t)header.indexCount * sizeof(uint32_t) + (size_t)header.lodCount * sizeof(MeshLod);
+	if (size != expected || header.lodCount == 0) return false;
+
+	const unsigned char* next = bytes + sizeof(header);
+	data.vertices = (const Vertex*)next;
+	data.vertexCount = header.vertexCount;
+	next += data.vertexCount * sizeof(Vertex);
+	data.indices = (const uint32_t*)next;
+	data.indexCount = header.indexCount;
+	next += data.indexCount * sizeof(uint32_t);
+	data.lods = (const MeshLod*)next;
+	data.lodCount = header.lodCount;
+	data.boundsMin = glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+	data.boundsMax = glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+
+	//A damaged file must not make the GPU read outside the buffers
+	for (size_t l = 0; l < data.lodCount; l++) {
+		const MeshLod& lod = data.lods[l];
+		if (lod.firstIndex < 0 || lod.indexCount < 0 || (size_t)lod.firstIndex + lod.indexCount > data.indexCount) return false;
+	}
+	for (size_t i = 0; i < data.indexCount; i++) {
+		if (data.indices[i] >= data.vertexCount) return false;
+	}
+	return true;
+}
@@ -0,0 +1,29 @@
+#ifndef MeshCache_header
+#define MeshCache_header
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "indexedMesh.h"
+#include "meshSimplifier.h"
+#include "fnvHash.h"
+
+using namespace std;
+
+//A finished model mesh, pointing into a mapped cache file or into the mesh it was built from
+struct MeshData
+{
+	const Vertex* vertices = nullptr;
+	size_t vertexCount = 0;
+	const uint32_t* indices = nullptr;
+	size_t indexCount = 0;
+	const MeshLod* lods = nullptr;
+	size_t lodCount = 0;
+	glm::vec3 boundsMin = glm::vec3(0.0f), boundsMax = glm::vec3(0.0f);
+};
+
+uint64_t hashMeshSource(uint64_t fileHash);
+bool writeMeshCache(const string& path, uint64_t sourceHash, const IndexedMesh& mesh, const vector<MeshLod>& lods);
+bool readMeshCache(const unsigned char* bytes, size_t size, uint64_t sourceHash, MeshData& data);
+
+#endif
@@ -0,0 +1,251 @@
+#include "meshSimplifier.h"
+
+#include <queue>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+
+//Sum of squared distances to a set of planes, a symmetric 4x4 matrix stored as its upper half
+struct Quadric
+{
+	double a2 = 0, ab = 0, ac = 0, ad = 0, b2 = 0, bc = 0, bd = 0, c2 = 0, cd = 0, d2 = 0;
+
+	void addPlane(glm::dvec3 n, double d, double weight) {
+		a2 += weight * n.x * n.x; ab += weight * n.x * n.y; ac += weight * n.x * n.z; ad += weight * n.x * d;
+		b2 += weight * n.y * n.y; bc += weight * n.y * n.z; bd += weight * n.y * d;
+		c2 += weight * n.z * n.z; cd += weight * n.z * d;
+		d2 += weight * d * d;
+	}
+	void add(const Quadric& q) {
+		a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad; b2 += q.b2; bc += q.bc; bd += q.bd; c2 += q.c2; cd += q.cd; d2 += q.d2;
+	}
+	double error(glm::dvec3 p) const {
+		return a2 * p.x * p.x + 2 * ab * p.x * p.y + 2 * ac * p.x * p.z + 2 * ad * p.x
+			+ b2 * p.y * p.y + 2 * bc * p.y * p.z + 2 * bd * p.y
+			+ c2 * p.z * p.z + 2 * cd * p.z + d2;
+	}
+};
+
+//Moving every vertex at position "from" onto position "to", cheapest first
+struct Collapse
+{
+	double cost;
+	uint32_t from, to;
+	bool operator<(const Collapse& other) const { return cost > other.cost; }
+};
+
+/// <summary>
+/// Removes triangles by collapsing edges, always the one that moves the surface least as
+/// measured by the error quadrics of the original planes (Garland and Heckbert). Vertices are
+/// only ever moved onto another existing vertex, so the result indexes the same vertex buffer.
+/// Borders and texture or normal seams are kept as they are.
+/// </summary>
+/// <param name="mesh">Mesh whose vertices are indexed</param>
+/// <param name="indices">Triangles to simplify</param>
+/// <param name="indexCount">Number of indices</param>
+/// <param name="targetTriangles">Stop at this many triangles</param>
+/// <param name="maxError">Stop before moving the surface further than this</param>
+/// <returns>Indices of the simplified triangles, more than the target if no good collapse is left</returns>
+vector<uint32_t> simplifyMesh(const IndexedMesh& mesh, const uint32_t* indices, size_t indexCount, size_t targetTriangles, float maxError) {
+	size_t vertexCount = mesh.vertices.size();
+	size_t triangleCount = indexCount / 3;
+
+	//Vertices at the same place are one position, split only by their normal or texture coordinate
+	vector<uint32_t> positionOf(vertexCount);
+	vector<glm::dvec3> position;
+	vector<uint32_t> wedgeCount, firstWedge;
+	unordered_map<uint64_t, uint32_t> positionIds;
+	for (size_t v = 0; v < vertexCount; v++) {
+		const glm::vec3& p = mesh.vertices[v].location;
+		uint32_t bits[3];
+		memcpy(bits, &p, sizeof(bits));
+		uint64_t key = ((uint64_t)bits[0] * 0x9E3779B97F4A7C15ull) ^ ((uint64_t)bits[1] * 0xC2B2AE3D27D4EB4Full) ^ ((uint64_t)bits[2] << 1);
+		auto found = positionIds.find(key);
+		//Hash collisions between different places count as another position
+		if (found == positionIds.end() || mesh.vertices[firstWedge[found->second]].location != p) {
+			uint32_t id = (uint32_t)position.size();
+			if (found == positionIds.end()) positionIds[key] = id;
+			position.push_back(glm::dvec3(p));
+			wedgeCount.push_back(0);
+			firstWedge.push_back((uint32_t)v);
+			positionOf[v] = id;
+		}
+		else {
+			positionOf[v] = found->second;
+		}
+		wedgeCount[positionOf[v]]++;
+	}
+	size_t positionCount = position.size();
+
+	//Edges used by one triangle are borders, edges used by more than two are not a surface
+	vector<bool> locked(positionCount, false);
+	unordered_map<uint64_t, int> edgeUse;
+	for (size_t t = 0; t < triangleCount; t++) {
+		for (int e = 0; e < 3; e++) {
+			uint32_t p = positionOf[indices[t * 3 + e]], q = positionOf[indices[t * 3 + (e + 1) % 3]];
+			edgeUse[(uint64_t)min(p, q) << 32 | max(p, q)]++;
+		}
+	}
+	for (const auto& edge : edgeUse) {
+		if (edge.second != 2) {
+			locked[edge.first >> 32] = true;
+			locked[edge.first & 0xFFFFFFFF] = true;
+		}
+	}
+	for (size_t p = 0; p < positionCount; p++) {
+		if (wedgeCount[p] > 1) locked[p] = true;
+	}
+
+	//Planes of the surrounding triangles and which triangles touch each position. The planes are not
+	//weighted by area, so the error is a sum of squared distances and can be compared to maxError.
+	vector<Quadric> quadric(positionCount);
+	vector<vector<uint32_t>> triangles(positionCount);
+	for (size_t t = 0; t < triangleCount; t++) {
+		glm::dvec3 a = position[positionOf[indices[t * 3]]], b = position[positionOf[indices[t * 3 + 1]]], c = position[positionOf[indices[t * 3 + 2]]];
+		glm::dvec3 normal = glm::cross(b - a, c - a);
+		double length = glm::length(normal);
+		if (length > 0) {
+			normal /= length;
+			for (int k = 0; k < 3; k++) quadric[positionOf[indices[t * 3 + k]]].addPlane(normal, -glm::dot(normal, a), 1.0);
+		}
+		for (int k = 0; k < 3; k++) triangles[positionOf[indices[t * 3 + k]]].push_back((uint32_t)t);
+	}
+
+	//Collapsed positions and vertices point at where they went
+	vector<uint32_t> positionTarget(positionCount), vertexTarget(vertexCount);
+	for (size_t p = 0; p < positionCount; p++) positionTarget[p] = (uint32_t)p;
+	for (size_t v = 0; v < vertexCount; v++) vertexTarget[v] = (uint32_t)v;
+	auto findPosition = [&](uint32_t p) {
+		while (positionTarget[p] != p) p = positionTarget[p] = positionTarget[positionTarget[p]];
+		return p;
+	};
+	auto findVertex = [&](uint32_t v) {
+		while (vertexTarget[v] != v) v = vertexTarget[v] = vertexTarget[vertexTarget[v]];
+		return v;
+	};
+	auto cornerPosition = [&](size_t t, int k) { return findPosition(positionOf[indices[t * 3 + k]]); };
+	auto cost = [&](uint32_t from, uint32_t to) {
+		Quadric q = quadric[from];
+		q.add(quadric[to]);
+		return q.error(position[to]);
+	};
+
+	priority_queue<Collapse> queue;
+	auto pushEdges = [&](uint32_t p) {
+		for (uint32_t t : triangles[p]) {
+			for (int k = 0; k < 3; k++) {
+				uint32_t q = cornerPosition(t, k);
+				if (q == p) continue;
+				if (!locked[p]) queue.push(Collapse{ cost(p, q), p, q });
+				if (!locked[q]) queue.push(Collapse{ cost(q, p), q, p });
+			}
+		}
+	};
+	for (size_t p = 0; p < positionCount; p++) {
+		if (!locked[p]) pushEdges((uint32_t)p);
+	}
+
+	vector<bool> alive(triangleCount, true);
+	size_t aliveCount = triangleCount;
+	while (aliveCount > targetTriangles && !queue.empty()) {
+		Collapse collapse = queue.top();
+		queue.pop();
+		if (collapse.cost > (double)maxError * maxError) break;
+		uint32_t a = collapse.from, b = collapse.to;
+		if (findPosition(a) != a || findPosition(b) != b || a == b) continue;
+
+		//Quadrics change as neighbours collapse, stale entries go back in with their new cost
+		double current = cost(a, b);
+		if (current > collapse.cost * (1 + 1e-9) + 1e-18) {
+			queue.push(Collapse{ current, a, b });
+			continue;
+		}
+
+		//The edge must still exist and no remaining triangle around a may flip over
+		int shared = 0;
+		uint32_t wedge = 0;
+		bool flips = false;
+		for (uint32_t t : triangles[a]) {
+			if (!alive[t]) continue;
+			uint32_t p[3] = { cornerPosition(t, 0), cornerPosition(t, 1), cornerPosition(t, 2) };
+			if (p[0] == b || p[1] == b || p[2] == b) {
+				shared++;
+				for (int k = 0; k < 3; k++) {
+					if (p[k] == b) wedge = findVertex(indices[t * 3 + k]);
+				}
+				continue;
+			}
+
+			glm::dvec3 before = glm::cross(position[p[1]] - position[p[0]], position[p[2]] - position[p[0]]);
+			glm::dvec3 moved[3];
+			for (int k = 0; k < 3; k++) moved[k] = position[p[k] == a ? b : p[k]];
+			glm::dvec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+			if (glm::dot(before, after) <= 0) {
+				flips = true;
+				break;
+			}
+		}
+		if (shared == 0 || flips) continue;
+
+		//a has one vertex, it now uses the vertex of b on its side of any seam at b
+		positionTarget[a] = b;
+		vertexTarget[findVertex(firstWedge[a])] = wedge;
+		quadric[b].add(quadric[a]);
+		for (uint32_t t : triangles[a]) {
+			if (!alive[t]) continue;
+			uint32_t p0 = cornerPosition(t, 0), p1 = cornerPosition(t, 1), p2 = cornerPosition(t, 2);
+			if (p0 == p1 || p1 == p2 || p0 == p2) {
+				alive[t] = false;
+				aliveCount--;
+			}
+			else {
+				triangles[b].push_back(t);
+			}
+		}
+		vector<uint32_t>().swap(triangles[a]);
+
+		//Drop dead triangles from b and queue the edges around it with their new costs
+		auto& around = triangles[b];
+		around.erase(remove_if(around.begin(), around.end(), [&](uint32_t t) { return !alive[t]; }), around.end());
+		pushEdges(b);
+	}
+
+	vector<uint32_t> result;
+	result.reserve(aliveCount * 3);
+	for (size_t t = 0; t < triangleCount; t++) {
+		if (!alive[t]) continue;
+		for (int k = 0; k < 3; k++) result.push_back(findVertex(indices[t * 3 + k]));
+	}
+	return result;
+}
+
+/// <summary>
+/// Adds simplified versions of a mesh to its index buffer, each made from the one before
+/// </summary>
+/// <param name="mesh">Mesh to extend, its current indices become level 0</param>
+/// <param name="targets">What every further level aims for, errors as a share of the bounding box diagonal</param>
+/// <returns>All levels from the full mesh down, levels that could not be reduced by at least a tenth are left out</returns>
+vector<MeshLod> generateLods(IndexedMesh& mesh, const vector<LodTarget>& targets) {
+	vector<MeshLod> lods = { MeshLod{ 0, (int)mesh.indices.size() } };
+	if (mesh.vertices.empty()) return lods;
+
+	glm::vec3 low = mesh.vertices[0].location, high = low;
+	for (const Vertex& vertex : mesh.vertices) {
+		low = glm::min(low, vertex.location);
+		high = glm::max(high, vertex.location);
+	}
+	float size = glm::length(high - low);
+
+	size_t fullTriangles = mesh.indices.size() / 3;
+	for (const LodTarget& target : targets) {
+		const MeshLod& previous = lods.back();
+		vector<uint32_t> simplified = simplifyMesh(mesh, mesh.indices.data() + previous.firstIndex, previous.indexCount,
+			(size_t)(fullTriangles * target.triangleFraction), target.maxError * size);
+		if (simplified.empty() || simplified.size() * 10 > (size_t)previous.indexCount * 9) break;
+
+		optimizeVertexCache(simplified, mesh.vertices.size());
+		lods.push_back(MeshLod{ (int)mesh.indices.size(), (int)simplified.size() });
+		mesh.indices.insert(mesh.indices.end(), simplified.begin(), simplified.end());
+	}
+	return lods;
+}
@@ -0,0 +1,31 @@
+#ifndef MeshSimplifier_header
+#define MeshSimplifier_header
+
+#include <vector>
+#include <cstdint>
+#include "indexedMesh.h"
+
+using namespace std;
+
+//One level of detail of a mesh: a range of its index buffer, all levels share the vertices
+struct MeshLod
+{
+	int firstIndex;
+	int indexCount;
+};
+
+//What a level of detail aims for: a share of the full triangle count, without moving the
+//surface further than a share of the model's size
+struct LodTarget
+{
+	float triangleFraction;
+	float maxError;
+};
+
+//Levels loadModel generates for every model
+const vector<LodTarget> modelLods = { { 0.5f, 0.02f }, { 0.15f, 0.06f } };
+
+vector<uint32_t> simplifyMesh(const IndexedMesh& mesh, const uint32_t* indices, size_t indexCount, size_t targetTriangles, float maxError);
+vector<MeshLod> generateLods(IndexedMesh& mesh, const vector<LodTarget>& targets);
+
+#endif
@@ -0,0 +1,93 @@
+//Asset packer, writes the loose shaders, textures, models and levels into one pack file the game maps at startup
+#include "assetPack.h"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+/// <summary>
+/// Prints the index of a pack and checks the hash of every asset
+/// </summary>
+/// <param name="path">Pack to check</param>
+/// <returns>false if the pack is missing or an asset does not match its hash</returns>
+bool listPack(const string& path) {
+	AssetPack pack(path, "");
+	if (!pack.isPacked()) {
+		cerr << "Unable to read pack " << path << endl;
+		return false;
+	}
+
+	bool valid = true;
+	for (uint32_t i = 0; i < pack.getEntryCount(); i++) {
+		const PackEntry& entry = pack.getEntries()[i];
+		bool matches = hashBytes(pack.getData(entry), (size_t)entry.size) == entry.hash;
+		cout << pack.getName(entry) << ": " << entry.size << " bytes at " << entry.offset << (matches ? "" : ", HASH MISMATCH") << endl;
+		valid = valid && matches;
+	}
+	return valid;
+}
+
+int main(int argc, char** argv) {
+	if (argc == 3 && strcmp(argv[1], "--list") == 0) return listPack(argv[2]) ? 0 : 1;
+	if (argc < 4) {
+		cerr << "Usage: " << argv[0] << " <output.pak> <root> <asset> [asset ...]\n"
+			<< "       " << argv[0] << " --list <pack>\n"
+			<< "Assets are paths relative to root, missing ones are skipped and stay loose files" << endl;
+		return 1;
+	}
+	string root = argv[2];
+	if (!root.empty() && root.back() != '/' && root.back() != '\\') root += '/';
+
+	//Sorted so the game can binary search the index
+	vector<string> names(argv + 3, argv + argc);
+	sort(names.begin(), names.end());
+	names.erase(unique(names.begin(), names.end()), names.end());
+
+	vector<unique_ptr<MappedFile>> files;
+	vector<PackEntry> entries;
+	string nameBytes;
+	for (const string& name : names) {
+		auto source = make_unique<MappedFile>(root + name);
+		if (!source->isOpen()) {
+			cout << "Skipping " << name << ", not found or empty" << endl;
+			continue;
+		}
+		PackEntry entry = { (uint32_t)nameBytes.size(), (uint32_t)name.size(), 0, source->size(), hashBytes(source->data(), source->size()) };
+		nameBytes += name;
+		entries.push_back(entry);
+		files.push_back(move(source));
+	}
+
+	PackHeader header = { packMagic, (uint32_t)entries.size(), sizeof(PackHeader) + entries.size() * sizeof(PackEntry), nameBytes.size() };
+	uint64_t offset = header.namesOffset + header.namesSize;
+	for (PackEntry& entry : entries) {
+		offset = (offset + packAlignment - 1) / packAlignment * packAlignment;
+		entry.offset = offset;
+		offset += entry.size;
+	}
+
+	ofstream out(argv[1], ios::binary);
+	if (!out) {
+		cerr << "Unable to write pack " << argv[1] << endl;
+		return 1;
+	}
+	out.write((const char*)&header, sizeof(header));
+	out.write((const char*)entries.data(), entries.size() * sizeof(PackEntry));
+	out.write(nameBytes.data(), nameBytes.size());
+	uint64_t written = header.namesOffset + header.namesSize;
+	const char padding[packAlignment] = {};
+	for (size_t i = 0; i < entries.size(); i++) {
+		out.write(padding, entries[i].offset - written);
+		out.write((const char*)files[i]->data(), entries[i].size);
+		written = entries[i].offset + entries[i].size;
+	}
+	if (!out) {
+		cerr << "Unable to write pack " << argv[1] << endl;
+		return 1;
+	}
+
+	cout << argv[1] << ": " << entries.size() << " assets, " << written / 1024 << " KB" << endl;
+	return 0;
+}
@@ -0,0 +1,47 @@
+#ifndef Pcg32_header
+#define Pcg32_header
+
+#include <cstdint>
+
+/// <summary>
+/// Small seedable random number generator (PCG32, XSH RR variant).
+/// Every instance has its own state, so agents can each own one and draw numbers
+/// from several threads without sharing anything. Same seed and stream, same numbers.
+/// </summary>
+class Pcg32 {
+private:
+	uint64_t state = 0;
+	uint64_t increment = 1;
+
+public:
+	Pcg32() = default;
+
+	/// <summary>
+	/// Seeds the generator
+	/// </summary>
+	/// <param name="seed">Starting point</param>
+	/// <param name="stream">Selects one of 2^63 independent sequences, e.g. the agent index</param>
+	Pcg32(uint64_t seed, uint64_t stream) {
+		increment = (stream << 1) | 1;
+		next();
+		state += seed;
+		next();
+	}
+
+	uint32_t next() {
+		uint64_t old = state;
+		state = old * 6364136223846793005ull + increment;
+		uint32_t xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+		uint32_t rot = (uint32_t)(old >> 59);
+		return (xorshifted >> rot) | (xorshifted << ((0u - rot) & 31));
+	}
+
+	/// <summary>
+	/// Number in [0, bound), mapped with a multiply instead of a division
+	/// </summary>
+	uint32_t nextBounded(uint32_t bound) {
+		return (uint32_t)(((uint64_t)next() * bound) >> 32);
+	}
+};
+
+#endif
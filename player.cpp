@@ -1,24 +1,18 @@
 #include"player.h"
 
-extern vector<glm::vec3> level;
-extern bool gameOver;
-extern bool win;
-
-Player::Player(glm::vec3 position, float _lastX, float _lastY) {
+Player::Player(glm::vec3 position) {
 	pitch = 0;
 	cameraPos = position;
-	lastX = _lastX, lastY = _lastY;
+	lastX = lastY = 0; // recalibrated on first mouse input
 }
 
 /// <summary>
 /// Takes in all legal input from player and handles it.
 /// </summary>
-/// <param name="window">Window to get input data from</param>
-void Player::processInput(GLFWwindow* window, float deltaTime) {
-	//Close window
-	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
-		glfwSetWindowShouldClose(window, true);
-
+/// <param name="input">Keys held this step</param>
+/// <param name="deltaTime">Time since last step</param>
+/// <param name="walls">Wall tiles to collide against</param>
+void Player::processInput(const PlayerInput& input, float deltaTime, const LevelGrid& walls) {
 	//Player movement (Take in direction and ground it so that player cant fly
 	glm::vec3 move = cameraFront;
 	glm::normalize(move);
@@ -26,29 +20,26 @@ void Player::processInput(GLFWwindow* window, float deltaTime) {
 	float cameraSpeed = 2.5f * deltaTime;
 
 	//Input handler
-	if (!win && !gameOver) { //if game not done
-		if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
-			movePlayer(move * cameraSpeed);
-		}
-		if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
-			movePlayer(-move * cameraSpeed);
-		}
-		if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
-			movePlayer(-glm::normalize(glm::cross(move, cameraUp)) * cameraSpeed);
-		}
-		if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
-			movePlayer(glm::normalize(glm::cross(move, cameraUp)) * cameraSpeed);
-		}
+	if (input.forward) {
+		movePlayer(move * cameraSpeed, walls);
+	}
+	if (input.back) {
+		movePlayer(-move * cameraSpeed, walls);
+	}
+	if (input.left) {
+		movePlayer(-glm::normalize(glm::cross(move, cameraUp)) * cameraSpeed, walls);
+	}
+	if (input.right) {
+		movePlayer(glm::normalize(glm::cross(move, cameraUp)) * cameraSpeed, walls);
 	}
 }
 
 /// <summary>
 ///  Applies new mouse input to camera
 /// </summary>
-/// <param name="window">GLFW window </param>
 /// <param name="xpos"> xpos of mouse on screen </param>
 /// <param name="ypos"> ypos of mouse on screen </param>
-void Player::mouseCallback(GLFWwindow* window, double xpos, double ypos) {
+void Player::mouseCallback(double xpos, double ypos) {
 	if (firstMouse) //Checks if first input and recalibrates to remove screen jump once user clicks screen
 	{
 		lastX = xpos;
@@ -86,52 +77,43 @@ void Player::mouseCallback(GLFWwindow* window, double xpos, double ypos) {
 /// Checks and applies input to player if possible
 /// </summary>
 /// <param name="input">New input from player controller</param>
-void Player::movePlayer(glm::vec3 input) {
+/// <param name="walls">Wall tiles to collide against</param>
+void Player::movePlayer(glm::vec3 input, const LevelGrid& walls) {
 	glm::vec3 test = cameraPos;
 
 	//x
 	test.x += input.x;
 	test.z = cameraPos.z;
-	if (!collides(test)) { //If no collision, apply x movement
+	if (!collides(test, walls)) { //If no collision, apply x movement
 		cameraPos.x = test.x;
 	}
 	//z
 	test.x = cameraPos.x;
 	test.z += input.z;
-	if (!collides(test)) { //if no collision, apply y movement
+	if (!collides(test, walls)) { //if no collision, apply y movement
 		cameraPos.z = test.z;
 	}
 }
 
 /// <summary>
-/// Checks a new position against all wall segments
+/// Checks a new position against the wall segments around it
 /// Returns true if collision, false if no collision
 /// </summary>
 /// <param name="pos">Proposed new position</param>
+/// <param name="walls">Wall tiles to check against</param>
 /// <returns>If that position collides or not</returns>
-bool Player::collides(glm::vec3 pos) {
-	bool xColl, zColl;
+bool Player::collides(glm::vec3 pos, const LevelGrid& walls) {
 	float size = 0.75;
-
-	for (int i = 0; i < level.size(); i++) {
-		glm::vec3 wall = level[i];
-
-		xColl = wall.x + size >= pos.x && wall.x - size <= pos.x; //X-axis overlap
-		zColl = wall.z + size >= pos.z && wall.z - size <= pos.z; //Y-axis overlap
-
-		if (xColl && zColl) { // both overlap :: collision
-			return true;
-		}
-	}
-	return false;
+	return walls.overlapsWall(pos, size);
 }
 
-glm::mat4 Player::generateView() {
-	glm::mat4 view = glm::mat4(1.0f); // make sure to initialize matrix to identity matrix first
-	if (!win && !gameOver) {
-		view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
-	}
-	return view;
+/// <summary>
+/// View matrix looking along the camera direction
+/// </summary>
+/// <param name="eye">Position to look from, usually interpolated between simulation steps</param>
+/// <returns>view matrix</returns>
+glm::mat4 Player::generateView(glm::vec3 eye) {
+	return glm::lookAt(eye, eye + cameraFront, cameraUp);
 }
 
 glm::vec3 Player::getPosition() {
@@ -1,13 +1,21 @@
 #ifndef Player_header
 #define Player_header
 
-#include <GLFW/glfw3.h>
 #include "glm/glm/glm.hpp"
 #include "glm/glm/gtc/matrix_transform.hpp"
 #include <vector>
+#include "levelGrid.h"
 
 using namespace std;
 
+//Movement keys held by the player during one simulation step
+struct PlayerInput {
+	bool forward = false;
+	bool back = false;
+	bool left = false;
+	bool right = false;
+};
+
 class Player{
 private:
 	//Camera variables
@@ -19,13 +27,13 @@ private:
 	bool firstMouse = true;
 
 	//functions
-	void movePlayer(glm::vec3 input);
-	bool collides(glm::vec3 pos);
+	void movePlayer(glm::vec3 input, const LevelGrid& walls);
+	bool collides(glm::vec3 pos, const LevelGrid& walls);
 public:
-	Player(glm::vec3 pos, float _lastX, float _lastY);
-	void processInput(GLFWwindow* window, float deltaTime);
-	void mouseCallback(GLFWwindow* window, double xpos, double ypos);
-	glm::mat4 Player::generateView();
-	glm::vec3 Player::getPosition();
+	Player(glm::vec3 pos);
+	void processInput(const PlayerInput& input, float deltaTime, const LevelGrid& walls);
+	void mouseCallback(double xpos, double ypos);
+	glm::mat4 generateView(glm::vec3 eye);
+	glm::vec3 getPosition();
 };
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,86 @@
+#include "ringBuffer.h"
+
+/// <summary>
+/// Creates the buffer. Draws pick the current region through getOffset, as base instance
+/// for instance data or as indirect offset for draw commands.
+/// </summary>
+/// <param name="_target">Binding point used to fill the buffer, e.g. GL_ARRAY_BUFFER</param>
+/// <param name="_regionSize">Most bytes written in one frame</param>
+RingBuffer::RingBuffer(GLenum _target, size_t _regionSize) {
+	target = _target;
+	regionSize = _regionSize > 0 ? _regionSize : 1;
+	GLsizeiptr size = (GLsizeiptr)(regionSize * regionCount);
+
+	glGenBuffers(1, &buffer);
+	glBindBuffer(target, buffer);
+
+	if (GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage) {
+		//Coherent, so writes become visible to the GPU without flushing
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(target, size, nullptr, flags);
+		persistent = (char*)glMapBufferRange(target, 0, size, flags);
+	}
+	else {
+		glBufferData(target, size, nullptr, GL_STREAM_DRAW);
+	}
+}
+
+/// <summary>
+/// Moves on to the next region and hands out its memory, waiting only if the GPU is
+/// still reading it from three frames ago
+/// </summary>
+/// <param name="size">Bytes that will be written, at most getRegionSize()</param>
+/// <returns>Where to write this frame's data</returns>
+void* RingBuffer::map(size_t size) {
+	region = (region + 1) % regionCount;
+	if (fences[region]) {
+		//Flush once so the fence is sure to be signalled, then wait as long as it takes
+		GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+		while (glClientWaitSync(fences[region], flags, 1000000) == GL_TIMEOUT_EXPIRED) flags = 0;
+		glDeleteSync(fences[region]);
+		fences[region] = nullptr;
+	}
+
+	if (persistent) {
+		mapped = persistent + getOffset();
+	}
+	else {
+		//The fence already guarantees the region is unused, the driver need not check again
+		glBindBuffer(target, buffer);
+		mapped = glMapBufferRange(target, getOffset(), size > 0 ? size : 1,
+			GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+	}
+	return mapped;
+}
+
+/// <summary>
+/// Ends writing the current region
+/// </summary>
+void RingBuffer::unmap() {
+	if (!persistent && mapped) {
+		glBindBuffer(target, buffer);
+		glUnmapBuffer(target);
+	}
+	mapped = nullptr;
+}
+
+/// <summary>
+/// Marks the current region as in use until the draw calls issued so far are done
+/// </summary>
+void RingBuffer::fence() {
+	if (fences[region]) glDeleteSync(fences[region]);
+	fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+/// <summary>
+/// Deletes the fences and the buffer
+/// </summary>
+void RingBuffer::destroy() {
+	for (GLsync& sync : fences) {
+		if (sync) glDeleteSync(sync);
+		sync = nullptr;
+	}
+	glDeleteBuffers(1, &buffer);
+	buffer = 0;
+	persistent = nullptr;
+}
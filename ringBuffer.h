@@ -0,0 +1,41 @@
+#ifndef RingBuffer_header
+#define RingBuffer_header
+
+#include <glad/glad.h>
+#include <cstddef>
+
+/// <summary>
+/// Buffer for data that changes every frame, split into three regions used in turn.
+/// The CPU writes one region while the GPU may still read the two before it, a fence per region
+/// tells when it is free again. With GL 4.4 or ARB_buffer_storage the buffer stays mapped for
+/// its whole life, otherwise each region is mapped unsynchronized while it is written.
+/// </summary>
+class RingBuffer {
+private:
+	static const int regionCount = 3;
+
+	GLuint buffer = 0;
+	GLenum target = GL_ARRAY_BUFFER;
+	size_t regionSize = 0;      // bytes per region
+	int region = 0;             // region written this frame
+	GLsync fences[regionCount] = {};
+	char* persistent = nullptr;
+	void* mapped = nullptr;
+
+public:
+	RingBuffer() = default;
+	RingBuffer(GLenum _target, size_t _regionSize);
+
+	void* map(size_t size);
+	void unmap();
+	void fence();
+	void destroy();
+
+	GLuint getBuffer() const { return buffer; }
+	size_t getRegionSize() const { return regionSize; }
+	//Byte offset of the region written this frame
+	size_t getOffset() const { return regionSize * region; }
+	bool isPersistent() const { return persistent != nullptr; }
+};
+
+#endif
@@ -2,19 +2,36 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec2 aTexCoord;
 layout (location = 2) in vec3 aNormal;
+layout (location = 3) in vec4 aInstance; // xyz position, w scale, one per instance
+layout (location = 4) in float aLayer;   // texture array layer of the mesh
 
 out vec2 TexCoord;
 out vec3 Normal;
 out vec3 FragPos;
+flat out float Layer;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+struct Light {
+	vec3 Direction;
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+};
+
+// per-frame data shared by every program, see FrameUniforms
+layout (std140) uniform FrameData {
+	mat4 view;
+	mat4 projection;
+	Light light;
+	vec3 CameraPosition;
+};
 
 void main()
 {
-	gl_Position = projection * view * model * vec4(aPos, 1.0f);
+	// instances are only moved and uniformly scaled, so the normal stays as it is
+	vec3 worldPos = aInstance.xyz + aPos * aInstance.w;
+	gl_Position = projection * view * vec4(worldPos, 1.0f);
 	TexCoord = vec2(aTexCoord.x, aTexCoord.y);
 	Normal = aNormal;
-	FragPos = vec3(model * vec4(aPos, 1.0));
+	FragPos = worldPos;
+	Layer = aLayer;
 }
\ No newline at end of file
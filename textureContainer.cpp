@@ -0,0 +1,138 @@
+#include "textureContainer.h"
+
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+
+/// <summary>
+/// Scales an image to another size with bilinear filtering
+/// </summary>
+/// <param name="pixels">Source image, rows of channels bytes per texel</param>
+/// <param name="width">Width of the source</param>
+/// <param name="height">Height of the source</param>
+/// <param name="out">Receives the scaled image</param>
+/// <param name="outWidth">Width to scale to</param>
+/// <param name="outHeight">Height to scale to</param>
+/// <param name="channels">Bytes per texel</param>
+void stretchImage(const unsigned char* pixels, int width, int height, unsigned char* out, int outWidth, int outHeight, int channels) {
+	for (int y = 0; y < outHeight; y++) {
+		float sy = max(0.0f, (y + 0.5f) * height / outHeight - 0.5f);
+		int y0 = min((int)sy, height - 1), y1 = min(y0 + 1, height - 1);
+		float fy = sy - y0;
+		for (int x = 0; x < outWidth; x++) {
+			float sx = max(0.0f, (x + 0.5f) * width / outWidth - 0.5f);
+			int x0 = min((int)sx, width - 1), x1 = min(x0 + 1, width - 1);
+			float fx = sx - x0;
+			for (int c = 0; c < channels; c++) {
+				float top = pixels[((size_t)y0 * width + x0) * channels + c] * (1 - fx) + pixels[((size_t)y0 * width + x1) * channels + c] * fx;
+				float bottom = pixels[((size_t)y1 * width + x0) * channels + c] * (1 - fx) + pixels[((size_t)y1 * width + x1) * channels + c] * fx;
+				out[((size_t)y * outWidth + x) * channels + c] = (unsigned char)(top * (1 - fy) + bottom * fy + 0.5f);
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Every mip level of an image, each half the size of the one before down to 1x1.
+/// A texel is the average of the up to four texels it covers, like glGenerateMipmap.
+/// </summary>
+/// <param name="pixels">Full size image, rows of channels bytes per texel</param>
+/// <param name="width">Width of the image</param>
+/// <param name="height">Height of the image</param>
+/// <param name="channels">Bytes per texel</param>
+/// <returns>Levels from the full size down</returns>
+vector<MipLevel> buildMipChain(const unsigned char* pixels, int width, int height, int channels) {
+	vector<MipLevel> levels;
+	levels.push_back(MipLevel{ width, height, vector<unsigned char>(pixels, pixels + (size_t)width * height * channels) });
+
+	while (levels.back().width > 1 || levels.back().height > 1) {
+		const MipLevel& above = levels.back();
+		MipLevel level{ max(1, above.width / 2), max(1, above.height / 2), {} };
+		level.pixels.resize((size_t)level.width * level.height * channels);
+
+		for (int y = 0; y < level.height; y++) {
+			//Odd sizes leave the last row or column out, as GL does
+			int y0 = min(y * 2, above.height - 1), y1 = min(y * 2 + 1, above.height - 1);
+			for (int x = 0; x < level.width; x++) {
+				int x0 = min(x * 2, above.width - 1), x1 = min(x * 2 + 1, above.width - 1);
+				for (int c = 0; c < channels; c++) {
+					int sum = above.pixels[((size_t)y0 * above.width + x0) * channels + c] + above.pixels[((size_t)y0 * above.width + x1) * channels + c]
+						+ above.pixels[((size_t)y1 * above.width + x0) * channels + c] + above.pixels[((size_t)y1 * above.width + x1) * channels + c];
+					level.pixels[((size_t)y * level.width + x) * channels + c] = (unsigned char)((sum + 2) / 4);
+				}
+			}
+		}
+		levels.push_back(move(level));
+	}
+	return levels;
+}
+
+/// <summary>
+/// Writes a mip chain to a texture container
+/// </summary>
+/// <param name="path">File to write</param>
+/// <param name="levels">Levels made by buildMipChain</param>
+/// <param name="channels">Bytes per texel</param>
+/// <returns>false if the file could not be written</returns>
+bool writeTextureContainer(const string& path, const vector<MipLevel>& levels, int channels) {
+	ofstream file(path, ios::binary);
+	if (!file) {
+		cout << "Unable to write texture " << path << endl;
+		return false;
+	}
+
+	TextureHeader header = { textureMagic, (uint32_t)levels[0].width, (uint32_t)levels[0].height, (uint32_t)channels, (uint32_t)levels.size(), {} };
+	vector<TextureLevel> table;
+	uint64_t offset = sizeof(header) + sizeof(TextureLevel) * levels.size();
+	for (const MipLevel& level : levels) {
+		table.push_back(TextureLevel{ (uint32_t)level.width, (uint32_t)level.height, offset, level.pixels.size() });
+		offset += level.pixels.size();
+	}
+
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)table.data(), table.size() * sizeof(TextureLevel));
+	for (const MipLevel& level : levels) file.write((const char*)level.pixels.data(), level.pixels.size());
+	return (bool)file;
+}
+
+/// <summary>
+/// Checks a mapped texture container and points at its level table. The pixels stay in the file.
+/// </summary>
+/// <param name="bytes">Mapped container, null if there is none</param>
+/// <param name="size">Size of the container</param>
+/// <param name="header">Receives the header</param>
+/// <param name="levels">Receives the level table, levelCount entries</param>
+/// <returns>false if the file is missing or damaged</returns>
+bool readTextureContainer(const unsigned char* bytes, size_t size, TextureHeader& header, const TextureLevel*& levels) {
+	if (!bytes || size < sizeof(TextureHeader)) return false;
+	memcpy(&header, bytes, sizeof(header));
+	if (header.magic != textureMagic || (header.channels != 3 && header.channels != 4) || header.levelCount == 0 || header.levelCount > 32 ||
+		size < sizeof(header) + sizeof(TextureLevel) * header.levelCount) {
+		return false;
+	}
+
+	levels = (const TextureLevel*)(bytes + sizeof(header));
+	uint32_t width = header.width, height = header.height;
+	for (uint32_t l = 0; l < header.levelCount; l++) {
+		const TextureLevel& level = levels[l];
+		if (level.width != width || level.height != height || level.size != (uint64_t)width * height * header.channels ||
+			level.offset > size || level.size > size - level.offset) {
+			return false;
+		}
+		width = max(1u, width / 2);
+		height = max(1u, height / 2);
+	}
+	return true;
+}
+
+/// <summary>
+/// Container next to an image, the same name with .tex instead of its extension
+/// </summary>
+/// <param name="imagePath">Path of the source image</param>
+string texturePathFor(const string& imagePath) {
+	size_t dot = imagePath.find_last_of('.');
+	size_t slash = imagePath.find_last_of("/\\");
+	if (dot == string::npos || (slash != string::npos && dot < slash)) return imagePath + ".tex";
+	return imagePath.substr(0, dot) + ".tex";
+}
@@ -0,0 +1,41 @@
+#ifndef TextureContainer_header
+#define TextureContainer_header
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+using namespace std;
+
+//Layout of a texture container (.tex): the header, one entry per mip level, then the pixels of every
+//level from the full size down to 1x1, each tightly packed rows of 8 bit channels
+const uint32_t textureMagic = 0x31584554; // "TEX1"
+struct TextureHeader
+{
+	uint32_t magic;
+	uint32_t width, height;
+	uint32_t channels;      // 3 for RGB, 4 for RGBA
+	uint32_t levelCount;
+	uint32_t reserved[3];
+};
+struct TextureLevel
+{
+	uint32_t width, height;
+	uint64_t offset;        // from the start of the file
+	uint64_t size;
+};
+
+//One mip level in memory, used while converting
+struct MipLevel
+{
+	int width, height;
+	vector<unsigned char> pixels;
+};
+
+void stretchImage(const unsigned char* pixels, int width, int height, unsigned char* out, int outWidth, int outHeight, int channels);
+vector<MipLevel> buildMipChain(const unsigned char* pixels, int width, int height, int channels);
+bool writeTextureContainer(const string& path, const vector<MipLevel>& levels, int channels);
+bool readTextureContainer(const unsigned char* bytes, size_t size, TextureHeader& header, const TextureLevel*& levels);
+string texturePathFor(const string& imagePath);
+
+#endif
@@ -0,0 +1,61 @@
+//Offline texture converter, decodes an image once and writes it with its whole mip chain to a texture
+//container the game maps and uploads at startup
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include "textureContainer.h"
+
+#include <iostream>
+#include <cstring>
+#include <cstdio>
+
+int main(int argc, char** argv) {
+	int width = 0, height = 0;
+	bool badSize = false;
+	vector<string> files;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+			badSize = sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0;
+		}
+		else {
+			files.push_back(argv[i]);
+		}
+	}
+	if (files.size() != 2 || badSize) {
+		cerr << "Usage: " << argv[0] << " [--size <width>x<height>] <image> <output.tex>" << endl;
+		return 1;
+	}
+
+	int imageWidth, imageHeight, channels;
+	if (!stbi_info(files[0].c_str(), &imageWidth, &imageHeight, &channels)) {
+		cerr << "Failed to load texture from " << files[0] << endl;
+		return 1;
+	}
+
+	//Grey and grey with alpha are widened to RGB and RGBA, the format is recorded in the container
+	int outChannels = channels == 4 || channels == 2 ? 4 : 3;
+	unsigned char* image = stbi_load(files[0].c_str(), &imageWidth, &imageHeight, &channels, outChannels);
+	if (!image) {
+		cerr << "Failed to load texture from " << files[0] << endl;
+		return 1;
+	}
+
+	vector<MipLevel> levels;
+	if (width && (width != imageWidth || height != imageHeight)) {
+		vector<unsigned char> stretched((size_t)width * height * outChannels);
+		stretchImage(image, imageWidth, imageHeight, stretched.data(), width, height, outChannels);
+		levels = buildMipChain(stretched.data(), width, height, outChannels);
+	}
+	else {
+		levels = buildMipChain(image, imageWidth, imageHeight, outChannels);
+	}
+	stbi_image_free(image);
+
+	if (!writeTextureContainer(files[1], levels, outChannels)) return 1;
+
+	size_t bytes = 0;
+	for (const MipLevel& level : levels) bytes += level.pixels.size();
+	cout << files[0] << " (" << imageWidth << "x" << imageHeight << ", " << channels << " channels) -> " << files[1] << ": "
+		<< levels[0].width << "x" << levels[0].height << " " << (outChannels == 4 ? "RGBA" : "RGB") << ", "
+		<< levels.size() << " levels, " << bytes / 1024 << " KB" << endl;
+	return 0;
+}
@@ -0,0 +1,238 @@
+#include "textureLoader.h"
+#include "textureContainer.h"
+#include "stb_image.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+
+/// <summary>
+/// Uploads the texture containers if there are any. Otherwise reads the image sizes, creates the placeholder
+/// and the texture array and queues one decode job per image.
+/// </summary>
+/// <param name="_jobs">Job system to decode on</param>
+/// <param name="assets">Pack or loose files to read the textures from</param>
+/// <param name="paths">Asset name of the image of each layer</param>
+TextureLoader::TextureLoader(JobSystem& _jobs, const AssetPack& assets, const vector<string>& paths) {
+	start = chrono::steady_clock::now();
+	jobs = &_jobs;
+
+	for (const string& path : paths) {
+		layers.push_back(make_unique<Layer>());
+		layers.back()->path = path;
+	}
+	int count = (int)layers.size();
+	if (loadContainers(assets)) return;
+
+	//Only the headers are read here, the array takes the size of the largest image
+	for (auto& layer : layers) {
+		layer->image = assets.open(layer->path);
+		int imageWidth, imageHeight, channels;
+		if (layer->image.isOpen() && stbi_info_from_memory(layer->image.data, (int)layer->image.size, &imageWidth, &imageHeight, &channels)) {
+			width = max(width, imageWidth);
+			height = max(height, imageHeight);
+		}
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	//One grey texel per layer to draw with until the images are in
+	vector<unsigned char> grey((size_t)count * 3, 128);
+	glGenTextures(1, &placeholder);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, placeholder);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGB8, 1, 1, count, 0, GL_RGB, GL_UNSIGNED_BYTE, grey.data());
+
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+	// set the texture wrapping parameters
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	// set texture filtering parameters
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	int levelCount = 1;
+	while ((width | height) >> levelCount) levelCount++;
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, levelCount, GL_RGB8, width, height, count);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	//The decode jobs write into pixel buffers mapped here, GL copies them into the array later
+	GLsizeiptr layerSize = (GLsizeiptr)width * height * 3;
+	for (auto& layer : layers) {
+		glGenBuffers(1, &layer->pixelBuffer);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, layer->pixelBuffer);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, layerSize, nullptr, GL_STREAM_DRAW);
+		layer->pixels = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, layerSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	for (auto& layer : layers) {
+		Layer* decoding = layer.get();
+		jobs->run(counter, [this, decoding] { decode(*decoding); });
+	}
+}
+
+/// <summary>
+/// Uploads every level of every layer from texture containers into immutable storage.
+/// The pixels are read straight from the mapped pack or files.
+/// </summary>
+/// <param name="assets">Pack or loose files to read the containers from</param>
+/// <returns>false if a container is missing, damaged or differs from the others</returns>
+bool TextureLoader::loadContainers(const AssetPack& assets) {
+	vector<Asset> files;
+	vector<const TextureLevel*> tables;
+	TextureHeader first = {};
+	for (auto& layer : layers) {
+		files.push_back(assets.open(texturePathFor(layer->path)));
+		TextureHeader header;
+		const TextureLevel* table;
+		if (!readTextureContainer(files.back().data, files.back().size, header, table)) return false;
+		if (tables.empty()) {
+			first = header;
+		}
+		else if (header.width != first.width || header.height != first.height || header.channels != first.channels || header.levelCount != first.levelCount) {
+			cout << "Texture containers differ in size or format, decoding the images instead" << endl;
+			return false;
+		}
+		tables.push_back(table);
+	}
+	if (tables.empty()) return false;
+
+	GLenum format = first.channels == 4 ? GL_RGBA : GL_RGB;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+	// set the texture wrapping parameters
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	// set texture filtering parameters
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, first.levelCount, first.channels == 4 ? GL_RGBA8 : GL_RGB8, first.width, first.height, (GLsizei)layers.size());
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (int i = 0; i < (int)layers.size(); i++) {
+		for (uint32_t l = 0; l < first.levelCount; l++) {
+			const TextureLevel& level = tables[i][l];
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, l, 0, 0, i, level.width, level.height, 1, format, GL_UNSIGNED_BYTE, files[i].data + level.offset);
+		}
+		layers[i]->uploaded = true;
+		layers[i]->uploadEnd = elapsed();
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	width = first.width;
+	height = first.height;
+	uploadedCount = (int)layers.size();
+	fromContainers = true;
+	return true;
+}
+
+double TextureLoader::elapsed() const {
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+/// <summary>
+/// Decodes one image into its pixel buffer, runs on any thread of the job system
+/// </summary>
+/// <param name="layer">Layer to fill</param>
+void TextureLoader::decode(Layer& layer) {
+	layer.decodeStart = elapsed();
+	int imageWidth, imageHeight, channels;
+	unsigned char* image = layer.image.isOpen() ?
+		stbi_load_from_memory(layer.image.data, (int)layer.image.size, &imageWidth, &imageHeight, &channels, 3) : nullptr;
+	unsigned char* out = layer.pixels;
+	size_t layerSize = (size_t)width * height * 3;
+
+	if (!out) {
+		//Mapping failed, the layer stays empty
+	}
+	else if (!image) {
+		cout << "Failed to load texture from " << layer.path << endl;
+		memset(out, 128, layerSize);
+	}
+	else if (imageWidth == width && imageHeight == height) {
+		memcpy(out, image, layerSize);
+	}
+	else {
+		stretchImage(image, imageWidth, imageHeight, out, width, height, 3);
+	}
+	stbi_image_free(image);
+	layer.image = Asset();
+	layer.decodeEnd = elapsed();
+	layer.decoded = true;
+}
+
+/// <summary>
+/// Uploads the layers that finished decoding since the last call, call once per frame on the GL thread
+/// </summary>
+/// <returns>true on the call that completed the texture array</returns>
+bool TextureLoader::update() {
+	if (reported) return false;
+	if (isDone()) {
+		reported = true;
+		return true;
+	}
+
+	//Without worker threads the jobs only run when someone waits for them
+	if (jobs->getThreadCount() == 1) jobs->wait(counter);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+	for (int i = 0; i < (int)layers.size(); i++) {
+		Layer& layer = *layers[i];
+		if (layer.uploaded || !layer.decoded) continue;
+
+		//Read from the bound pixel buffer, the driver copies it without holding up this thread
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, layer.pixelBuffer);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, width, height, 1, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		glDeleteBuffers(1, &layer.pixelBuffer);
+		layer.pixelBuffer = 0;
+		layer.pixels = nullptr;
+
+		layer.uploaded = true;
+		layer.uploadEnd = elapsed();
+		uploadedCount++;
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	if (!isDone()) return false;
+	glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+	reported = true;
+	return true;
+}
+
+/// <summary>
+/// Prints when each image was decoded and uploaded, in ms since the loader started
+/// </summary>
+/// <param name="out">Stream to print to</param>
+void TextureLoader::printTimeline(ostream& out) const {
+	for (const auto& layer : layers) {
+		string name = layer->path.substr(layer->path.find_last_of("/\\") + 1);
+		if (fromContainers) {
+			out << "  " << name << ": uploaded from texture container " << layer->uploadEnd << " ms" << endl;
+		}
+		else {
+			out << "  " << name << ": decoded " << layer->decodeStart << " - " << layer->decodeEnd << " ms, uploaded "
+				<< layer->uploadEnd << " ms" << endl;
+		}
+	}
+}
+
+/// <summary>
+/// Waits for decodes still running, then deletes the pixel buffers and textures
+/// </summary>
+void TextureLoader::destroy() {
+	jobs->wait(counter);
+	for (auto& layer : layers) {
+		if (!layer->pixelBuffer) continue;
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, layer->pixelBuffer);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		glDeleteBuffers(1, &layer->pixelBuffer);
+		layer->pixelBuffer = 0;
+	}
+	glDeleteTextures(1, &texture);
+	glDeleteTextures(1, &placeholder);
+}
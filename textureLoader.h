@@ -0,0 +1,65 @@
+#ifndef TextureLoader_header
+#define TextureLoader_header
+
+#include <glad/glad.h>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <ostream>
+#include "jobSystem.h"
+#include "assetPack.h"
+
+using namespace std;
+
+/// <summary>
+/// Loads images into the layers of one texture array in the background, so meshes with different
+/// textures can be drawn in one call. Images are decoded on the job system, each straight into a
+/// mapped pixel buffer, and the main thread only hands finished layers to GL in update().
+/// Until every layer is in, getTexture() returns a grey placeholder array with the same layers.
+/// Smaller images are stretched to the largest.
+/// When every image has a texture container next to it (see textureConverter.cpp), all of the same size
+/// and format, those are uploaded straight from the mapped files instead, with no decoding at all.
+/// </summary>
+class TextureLoader {
+private:
+	struct Layer {
+		string path;
+		Asset image;                        // encoded image, from the pack or a loose file
+		GLuint pixelBuffer = 0;
+		unsigned char* pixels = nullptr;    // mapped pixel buffer, written by the decode job
+		atomic<bool> decoded{ false };
+		bool uploaded = false;
+		double decodeStart = 0, decodeEnd = 0, uploadEnd = 0;   // ms since the loader started
+	};
+
+	JobSystem* jobs = nullptr;
+	JobCounter counter;
+	vector<unique_ptr<Layer>> layers;
+	int width = 1, height = 1;
+	int uploadedCount = 0;
+	bool fromContainers = false;
+	bool reported = false;
+	GLuint texture = 0, placeholder = 0;
+	chrono::steady_clock::time_point start;
+
+	bool loadContainers(const AssetPack& assets);
+	void decode(Layer& layer);
+	double elapsed() const;
+
+public:
+	TextureLoader(JobSystem& _jobs, const AssetPack& assets, const vector<string>& paths);
+	TextureLoader(const TextureLoader&) = delete;
+	TextureLoader& operator=(const TextureLoader&) = delete;
+
+	bool update();
+	void printTimeline(ostream& out) const;
+	void destroy();
+
+	bool isDone() const { return uploadedCount == (int)layers.size(); }
+	GLuint getTexture() const { return isDone() ? texture : placeholder; }
+	chrono::steady_clock::time_point getStart() const { return start; }
+};
+
+#endif
@@ -5,32 +5,53 @@
 #define TINYOBJLOADER_IMPLEMENTATION
 #include "tinyobjloader/tiny_obj_loader.h"
 #include <GLFW/glfw3.h>
+#include <chrono>
+#include "indexedMesh.h"
+#include "meshSimplifier.h"
+#include "meshCache.h"
+#include "meshArena.h"
+#include "assetPack.h"
 
 using namespace std;
 
-GLuint loadModel(const string path, const string file, int& size);
-void cleanVAO(GLuint& vao);
-GLuint wallSegment();
-
-//Data structure used in the following function
-struct Vertex
-{
-	glm::vec3 location;
-	glm::vec3 normals;
-	glm::vec2 texCoords;
-};
+ArenaMesh loadModel(const AssetPack& assets, const string path, const string file, MeshArena& arena, float layer, vector<MeshLod>& lods);
 
 /// <summary>
-/// Loads 3D model from path
+/// Loads 3D model from path as an indexed mesh into the arena.
+/// Simplified levels of detail are generated and stored behind the full mesh in the index buffer.
+/// The finished mesh is cached next to the obj file (file.mesh) and mapped straight from there
+/// on later runs, until the obj file changes. Both are read from the asset pack when it has them.
 /// </summary>
-/// <param name="path">Path to look</param>
+/// <param name="assets">Pack or loose files to read the model from</param>
+/// <param name="path">Path to look, relative to the project root</param>
 /// <param name="file">Which obj file to get</param>
-/// <param name="size">Size callback variable</param>
-/// <returns>Newly generated VAO for model</returns>
-GLuint loadModel(const std::string path, const std::string file, int& size)
+/// <param name="arena">Arena to add the model to</param>
+/// <param name="layer">Texture array layer of the model</param>
+/// <param name="lods">Receives the index range of every level of detail, full detail first</param>
+/// <returns>Where the model is in the arena</returns>
+ArenaMesh loadModel(const AssetPack& assets, const std::string path, const std::string file, MeshArena& arena, float layer, vector<MeshLod>& lods)
 {
-	//We create a vector of Vertex structs. OpenGL can understand these, and so will accept them as input.
-	vector<Vertex> vertices;
+	auto start = chrono::steady_clock::now();
+
+	//Hashing the source is far cheaper than parsing it, a cache built from the same bytes is used as it is.
+	//A model in the pack is not hashed again, the pack index has its hash.
+	string cacheName = path + file + ".mesh";
+	Asset source = assets.open(path + file);
+	uint64_t sourceHash = source.isOpen() ? hashMeshSource(source.getHash()) : 0;
+	{
+		Asset cache = assets.open(cacheName);
+		MeshData data;
+		if (sourceHash != 0 && readMeshCache(cache.data, cache.size, sourceHash, data)) {
+			lods.assign(data.lods, data.lods + data.lodCount);
+			ArenaMesh placed = arena.addMesh(data.vertices, data.vertexCount, data.indices, data.indexCount, layer);
+
+			chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+			cout << file << ": " << data.vertexCount << " vertices, " << lods[0].indexCount / 3 << " triangles, LODs";
+			for (const MeshLod& lod : lods) cout << " " << lod.indexCount / 3;
+			cout << ", mapped from cache in " << elapsed.count() * 1000 << " ms" << endl;
+			return placed;
+		}
+	}
 
 	//Some variables that we are going to use to store data from tinyObj
 	tinyobj::attrib_t attrib;
@@ -42,7 +63,12 @@ GLuint loadModel(const std::string path, const std::string file, int& size)
 	string err;
 
 	//We use tinobj to load our models. Feel free to find other .obj files and see if you can load them.
-	tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, (path + file).c_str(), (path).c_str());
+	//It reads the mapped obj in place, materials still come from the loose files
+	if (!source.isOpen()) cerr << "Unable to read model " << path + file << endl;
+	AssetStreamBuffer sourceBuffer(source);
+	istream sourceStream(&sourceBuffer);
+	tinyobj::MaterialFileReader materialReader(assets.loosePath(path));
+	tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, &sourceStream, &materialReader);
 
 	if (!warn.empty()) {
 		cout << warn << std::endl;
@@ -52,152 +78,35 @@ GLuint loadModel(const std::string path, const std::string file, int& size)
 		cerr << err << std::endl;
 	}
 
-	//For each shape defined in the obj file
-	for (auto shape : shapes)
+	//Every corner of every face in all shapes, tinyobj already split the faces into triangles
+	size_t cornerCount = 0;
+	for (const auto& shape : shapes) cornerCount += shape.mesh.indices.size();
+	vector<MeshCorner> corners;
+	corners.reserve(cornerCount);
+	for (const auto& shape : shapes)
 	{
-		//We find each mesh
-		for (auto meshIndex : shape.mesh.indices)
+		for (const auto& meshIndex : shape.mesh.indices)
 		{
-			//And store the data for each vertice, including normals
-			glm::vec3 vertice = {
-				attrib.vertices[meshIndex.vertex_index * 3],
-				attrib.vertices[(meshIndex.vertex_index * 3) + 1],
-				attrib.vertices[(meshIndex.vertex_index * 3) + 2]
-			};
-			glm::vec3 normal = {
-				attrib.normals[meshIndex.normal_index * 3],
-				attrib.normals[(meshIndex.normal_index * 3) + 1],
-				attrib.normals[(meshIndex.normal_index * 3) + 2]
-			};
-			glm::vec2 textureCoordinate = {                         //These go unnused, but if you want textures, you will need them.
-				attrib.texcoords[meshIndex.texcoord_index * 2],
-				attrib.texcoords[(meshIndex.texcoord_index * 2) + 1]
-			};
-
-			vertices.push_back({ vertice, normal, textureCoordinate }); //We add our new vertice struct to our vector
-
+			corners.push_back({ meshIndex.vertex_index, meshIndex.normal_index, meshIndex.texcoord_index });
 		}
 	}
 
-	GLuint VAO;
-	glGenVertexArrays(1, &VAO);
-	glBindVertexArray(VAO);
-
-	GLuint VBO;
-	glGenBuffers(1, &VBO);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-
-	//As you can see, OpenGL will accept a vector of structs as a valid input here
-	glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * vertices.size(), &vertices[0], GL_STATIC_DRAW);
-
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 8, nullptr);
-
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 8, (void*)(sizeof(float) * 3));
-
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 8, (void*)(sizeof(float) * 6));
-
-	//This will be needed later to specify how much we need to draw. Look at the main loop to find this variable again.
-	size = vertices.size();
-
-	return VAO;
-}
-
-/// <summary>
-/// Deletes data within VAO
-/// </summary>
-/// <param name="vao">VAO to be cleaned</param>
-void cleanVAO(GLuint& vao)
-{
-	GLint nAttr = 0;
-	std::set<GLuint> vbos;
-
-	GLint eboId;
-	glGetVertexArrayiv(vao, GL_ELEMENT_ARRAY_BUFFER_BINDING, &eboId);
-	glDeleteBuffers(1, (GLuint*)&eboId);
-
-	glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &nAttr);
-	glBindVertexArray(vao);
-
-	for (int iAttr = 0; iAttr < nAttr; ++iAttr)
-	{
-		GLint vboId = 0;
-		glGetVertexAttribiv(iAttr, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, &vboId);
-		if (vboId > 0)
-		{
-			vbos.insert(vboId);
-		}
-
-		glDisableVertexAttribArray(iAttr);
-	}
+	//Corners with the same position, normal and texture coordinate become one vertex
+	IndexedMesh mesh = buildIndexedMesh(attrib.vertices, attrib.normals, attrib.texcoords, corners);
+	size_t fullIndices = mesh.indices.size();
 
-	for (auto vbo : vbos)
-	{
-		glDeleteBuffers(1, &vbo);
-	}
+	//Coarser versions for instances far from the camera, they only add indices
+	lods = generateLods(mesh, modelLods);
 
-	glDeleteVertexArrays(1, &vao);
-}
+	chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+	cout << file << ": " << mesh.vertices.size() << " vertices (" << corners.size() << " unindexed), "
+		<< fullIndices / 3 << " triangles, ACMR " << averageCacheMissRatio(vector<uint32_t>(mesh.indices.begin(), mesh.indices.begin() + fullIndices)) << ", LODs";
+	for (const MeshLod& lod : lods) cout << " " << lod.indexCount / 3;
+	cout << ", loaded in " << elapsed.count() * 1000 << " ms" << endl;
 
-/// <summary>
-/// VAO for wall segments of the map
-/// </summary>
-/// <returns>New VAO</returns>
-GLuint wallSegment() {
-	float vertices[] = {
-		-0.5f, -0.5f, -0.5f,  0.0f, 0.0f, 0.0f,  0.0f, -1.0f,
-		 0.5f, -0.5f, -0.5f,  1.0f, 0.0f, 0.0f,  0.0f, -1.0f,
-		 0.5f,  0.5f, -0.5f,  1.0f, 1.0f, 0.0f,  0.0f, -1.0f,
-		 0.5f,  0.5f, -0.5f,  1.0f, 1.0f, 0.0f,  0.0f, -1.0f,
-		-0.5f,  0.5f, -0.5f,  0.0f, 1.0f, 0.0f,  0.0f, -1.0f,
-		-0.5f, -0.5f, -0.5f,  0.0f, 0.0f, 0.0f,  0.0f, -1.0f,
-
-		-0.5f, -0.5f,  0.5f,  0.0f, 0.0f, 0.0f,  0.0f,  1.0f,
-		 0.5f, -0.5f,  0.5f,  1.0f, 0.0f, 0.0f,  0.0f,  1.0f,
-		 0.5f,  0.5f,  0.5f,  1.0f, 1.0f, 0.0f,  0.0f,  1.0f,
-		 0.5f,  0.5f,  0.5f,  1.0f, 1.0f, 0.0f,  0.0f,  1.0f,
-		-0.5f,  0.5f,  0.5f,  0.0f, 1.0f, 0.0f,  0.0f,  1.0f,
-		-0.5f, -0.5f,  0.5f,  0.0f, 0.0f, 0.0f,  0.0f,  1.0f,
-
-		-0.5f,  0.5f,  0.5f,  1.0f, 0.0f, -1.0f,  0.0f,  0.0f,
-		-0.5f,  0.5f, -0.5f,  1.0f, 1.0f, -1.0f,  0.0f,  0.0f,
-		-0.5f, -0.5f, -0.5f,  0.0f, 1.0f, -1.0f,  0.0f,  0.0f,
-		-0.5f, -0.5f, -0.5f,  0.0f, 1.0f, -1.0f,  0.0f,  0.0f,
-		-0.5f, -0.5f,  0.5f,  0.0f, 0.0f, -1.0f,  0.0f,  0.0f,
-		-0.5f,  0.5f,  0.5f,  1.0f, 0.0f, -1.0f,  0.0f,  0.0f,
-
-		 0.5f,  0.5f,  0.5f,  1.0f, 0.0f, 1.0f,  0.0f,  0.0f,
-		 0.5f,  0.5f, -0.5f,  1.0f, 1.0f, 1.0f,  0.0f,  0.0f,
-		 0.5f, -0.5f, -0.5f,  0.0f, 1.0f, 1.0f,  0.0f,  0.0f,
-		 0.5f, -0.5f, -0.5f,  0.0f, 1.0f, 1.0f,  0.0f,  0.0f,
-		 0.5f, -0.5f,  0.5f,  0.0f, 0.0f, 1.0f,  0.0f,  0.0f,
-		 0.5f,  0.5f,  0.5f,  1.0f, 0.0f, 1.0f,  0.0f,  0.0f,
-
-		 //Removed top and bottom faces as they will never be seen anyways
-	};
-
-	unsigned int VBO, VAO;
-	glGenVertexArrays(1, &VAO);
-	glGenBuffers(1, &VBO);
-
-	glBindVertexArray(VAO);
-
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-	// position attribute
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-	// texture coord attribute
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(1);
-	// normal attribute
-	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(5 * sizeof(float)));
-	glEnableVertexAttribArray(2);
-
-	return VAO;
+	//The cache is written as a loose file, repacking picks it up
+	if (sourceHash != 0) writeMeshCache(assets.loosePath(cacheName), sourceHash, mesh, lods);
+	return arena.addMesh(mesh.vertices.data(), mesh.vertices.size(), mesh.indices.data(), mesh.indices.size(), layer);
 }
 
 #endif
@@ -0,0 +1,359 @@
+#include "visibilitySet.h"
+#include "junctionGraph.h"
+#include "fnvHash.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+
+//Cache file layout: header, then the tile, start and chunk arrays as 32 bit values
+const uint32_t cacheMagic = 0x33535650; // "PVS3"
+struct CacheHeader {
+	uint32_t magic;
+	int32_t sizeX, sizeZ, chunkSize;
+	float maxDistance;
+	uint32_t reserved;
+	uint64_t levelHash;
+	uint64_t tileCount, setStartCount, chunkCount;
+};
+
+//What castTile needs to know about the level, chunk lookups are split into rows and columns
+//so a tile's chunk is one addition
+struct CastContext {
+	LevelView level;
+	float maxDistance;
+	vector<uint32_t> rowChunk, columnChunk;
+	vector<unsigned char> rowEdge, columnEdge;  // first or last tile of a chunk along that axis
+};
+
+//A ray leaving the source tile: where it crosses the tile's front edge relative to the tile, and its
+//slope, the secondary axis distance per tile along the primary axis
+struct Ray { float offset, slope; };
+
+//A beam is a convex polygon of rays, its corners stored in a shared list
+struct Beam { uint32_t first, count; };
+
+/// <summary>
+/// Cuts a beam down to the rays that are on one side of a bound at some distance from the source tile
+/// </summary>
+/// <param name="polygon">Corners of the beam, replaced by the corners of the rays kept</param>
+/// <param name="scratch">Scratch list</param>
+/// <param name="distance">Tiles past the front edge of the source tile</param>
+/// <param name="bound">Secondary axis position relative to the source tile</param>
+/// <param name="above">Keep the rays above the bound instead of below it</param>
+static void clipBeam(vector<Ray>& polygon, vector<Ray>& scratch, float distance, float bound, bool above) {
+	scratch.clear();
+	float sign = above ? 1.0f : -1.0f;
+	for (size_t i = 0; i < polygon.size(); i++) {
+		const Ray& a = polygon[i];
+		const Ray& b = polygon[(i + 1) % polygon.size()];
+		float insideA = sign * (a.offset + a.slope * distance - bound);
+		float insideB = sign * (b.offset + b.slope * distance - bound);
+		if (insideA >= 0) scratch.push_back(a);
+		if ((insideA >= 0) != (insideB >= 0)) {
+			float t = insideA / (insideA - insideB);
+			scratch.push_back(Ray{ a.offset + (b.offset - a.offset) * t, a.slope + (b.slope - a.slope) * t });
+		}
+	}
+	polygon.swap(scratch);
+}
+
+/// <summary>
+/// Shadow casting from the whole square of a tile, exact on the grid: every tile any ray from any point
+/// of the tile reaches before a wall, within maxDistance, is visited, and the wall that stops it as well.
+/// The view is split in four quarters around the axes. Each one is walked a line of tiles at a time away
+/// from the tile while keeping the beams of rays that got through every line so far, walls cut them into
+/// narrower beams. Rays start from anywhere on the tile, so a beam is a polygon of where rays leave the
+/// tile and their slopes rather than a range of slopes.
+/// </summary>
+/// <param name="context">Level and view distance</param>
+/// <param name="x">x tile, must be walkable</param>
+/// <param name="z">z tile, must be walkable</param>
+/// <param name="visit">Called with every tile seen, may repeat tiles</param>
+template <typename Visit>
+static void castArea(const CastContext& context, int x, int z, Visit visit) {
+	const LevelView& level = context.level;
+	const float maxDistance = context.maxDistance;
+	const float slack = 1e-4f;  // rays that graze a wall corner count as passing it
+	vector<Ray> rays, nextRays, polygon, scratch;
+	vector<Beam> beams, next;
+	auto addBeam = [&](vector<Ray>& corners) {
+		if (corners.empty()) return;
+		next.push_back(Beam{ (uint32_t)nextRays.size(), (uint32_t)corners.size() });
+		nextRays.insert(nextRays.end(), corners.begin(), corners.end());
+	};
+
+	visit(x, z);
+	for (int quarter = 0; quarter < 4; quarter++) {
+		//Lines run across the primary axis, mirrored quarters count their lines the other way
+		bool alongX = quarter < 2;
+		int sign = (quarter & 1) ? -1 : 1;
+		int lineCount = alongX ? level.sizeX : level.sizeZ, sideCount = alongX ? level.sizeZ : level.sizeX;
+		int ownLine = alongX ? x : z, ownSide = alongX ? z : x;
+		auto isOpen = [&](int line, int side) { return alongX ? level.isOpen(line, side) : level.isOpen(side, line); };
+
+		//Rays through the tile that rise or fall by up to one tile per line. Those leaving it through
+		//a side edge cross the tile beside it in the same line first, which has to be open for them.
+		next.clear();
+		nextRays.clear();
+		const Ray rising[4] = { { 0, 0 }, { 1, 0 }, { 2, 1 }, { 0, 1 } };
+		const Ray falling[4] = { { -1, -1 }, { 1, -1 }, { 1, 0 }, { 0, 0 } };
+		for (const Ray* start : { rising, falling }) {
+			polygon.assign(start, start + 4);
+			if (!isOpen(ownLine, ownSide + 1)) clipBeam(polygon, scratch, 0.0f, 1.0f + slack, false);
+			if (!isOpen(ownLine, ownSide - 1)) clipBeam(polygon, scratch, 0.0f, -slack, true);
+			addBeam(polygon);
+		}
+		beams.swap(next);
+		rays.swap(nextRays);
+
+		for (int row = 0; !beams.empty(); row++) {
+			int line = ownLine + sign * (row + 1);
+			float enter = (float)row, exit = row + 1.0f;   // distance from the tile to both sides of the line
+			if (line < 0 || line >= lineCount || enter > maxDistance) break;
+
+			next.clear();
+			nextRays.clear();
+			for (const Beam& beam : beams) {
+				float sideMin = FLT_MAX, sideMax = -FLT_MAX;
+				for (uint32_t i = beam.first; i < beam.first + beam.count; i++) {
+					const Ray& ray = rays[i];
+					sideMin = min(sideMin, ray.offset + ray.slope * (ray.slope < 0 ? exit : enter));
+					sideMax = max(sideMax, ray.offset + ray.slope * (ray.slope > 0 ? exit : enter));
+				}
+				int first = max(0, ownSide + (int)floor(sideMin - slack)), last = min(sideCount - 1, ownSide + (int)floor(sideMax + slack));
+
+				//Rays of the beam that cross the line inside a run of open tiles go on to the next line
+				int runStart = -1;
+				for (int side = first; side <= last + 1; side++) {
+					bool open = false;
+					if (side <= last) {
+						float gap = (float)max(0, max(side - ownSide - 1, ownSide - side - 1));
+						if (enter * enter + gap * gap > maxDistance * maxDistance) {
+							open = false;
+						}
+						else {
+							alongX ? visit(line, side) : visit(side, line);
+							open = isOpen(line, side);
+						}
+					}
+					if (open && runStart < 0) runStart = side;
+					if (open || runStart < 0) continue;
+
+					//Both the side entering and the side leaving the line have to be within the run
+					float runLow = runStart - ownSide - slack, runHigh = side - ownSide + slack;
+					polygon.assign(rays.begin() + beam.first, rays.begin() + beam.first + beam.count);
+					if (runLow > sideMin) {
+						clipBeam(polygon, scratch, enter, runLow, true);
+						clipBeam(polygon, scratch, exit, runLow, true);
+					}
+					if (runHigh < sideMax) {
+						clipBeam(polygon, scratch, enter, runHigh, false);
+						clipBeam(polygon, scratch, exit, runHigh, false);
+					}
+					addBeam(polygon);
+					runStart = -1;
+				}
+			}
+			beams.swap(next);
+			rays.swap(nextRays);
+		}
+	}
+}
+
+/// <summary>
+/// Collects the chunks seen from anywhere on a tile. The chunks next to every
+/// open tile seen are added too, so ghosts stepping in from around a corner are not dropped.
+/// </summary>
+/// <param name="context">Level and chunk lookups</param>
+/// <param name="x">x tile, must be walkable</param>
+/// <param name="z">z tile, must be walkable</param>
+/// <param name="stamp">Per chunk scratch, marks chunks already collected for this tile</param>
+/// <param name="out">Receives the chunks, unsorted</param>
+static void castTile(const CastContext& context, int x, int z, vector<uint32_t>& stamp, vector<uint32_t>& out) {
+	const LevelView& level = context.level;
+	uint32_t mark = (uint32_t)(x * level.sizeZ + z) + 1;
+	out.clear();
+	auto addChunk = [&](uint32_t chunk) {
+		if (stamp[chunk] != mark) {
+			stamp[chunk] = mark;
+			out.push_back(chunk);
+		}
+	};
+	auto visit = [&](int tx, int tz) {
+		addChunk(context.rowChunk[tx] + context.columnChunk[tz]);
+
+		//Neighbours can only be in another chunk on the edge of one
+		if (level.isOpen(tx, tz) && (context.rowEdge[tx] || context.columnEdge[tz])) {
+			for (int d = 0; d < 4; d++) {
+				int nx = tx + dirsX[d], nz = tz + dirsZ[d];
+				if (nx >= 0 && nz >= 0 && nx < level.sizeX && nz < level.sizeZ) {
+					addChunk(context.rowChunk[nx] + context.columnChunk[nz]);
+				}
+			}
+		}
+	};
+
+	castArea(context, x, z, visit);
+}
+
+/// <summary>
+/// Finds the visible chunks of every walkable tile
+/// </summary>
+/// <param name="level">Level to build the sets for</param>
+/// <param name="_chunkSize">Tiles along each side of a chunk, see ChunkCulling</param>
+/// <param name="_maxDistance">Nothing further than this many tiles is seen, the far plane of the camera</param>
+/// <param name="jobs">Spreads the rows over threads, null builds on the calling thread</param>
+VisibilitySet::VisibilitySet(LevelView level, int _chunkSize, float _maxDistance, JobSystem* jobs) {
+	sizeX = level.sizeX;
+	sizeZ = level.sizeZ;
+	chunkSize = _chunkSize;
+	maxDistance = _maxDistance;
+	levelHash = hashLevel(level);
+	int chunksX = max(1, (sizeX + chunkSize - 1) / chunkSize);
+	int chunksZ = max(1, (sizeZ + chunkSize - 1) / chunkSize);
+
+	CastContext context;
+	context.level = level;
+	context.maxDistance = maxDistance;
+	for (int x = 0; x < sizeX; x++) {
+		context.rowChunk.push_back((uint32_t)((x / chunkSize) * chunksZ));
+		context.rowEdge.push_back(x % chunkSize == 0 || x % chunkSize == chunkSize - 1);
+	}
+	for (int z = 0; z < sizeZ; z++) {
+		context.columnChunk.push_back((uint32_t)(z / chunkSize));
+		context.columnEdge.push_back(z % chunkSize == 0 || z % chunkSize == chunkSize - 1);
+	}
+
+	//Every row is cast on its own, the lists of its tiles stored one after another
+	vector<vector<uint32_t>> rowChunks(sizeX);
+	vector<vector<uint32_t>> rowStarts(sizeX);
+	auto castRows = [&](int begin, int end) {
+		vector<uint32_t> stamp((size_t)chunksX * chunksZ, 0);
+		vector<uint32_t> visible;
+		for (int x = begin; x < end; x++) {
+			rowStarts[x].push_back(0);
+			for (int z = 0; z < sizeZ; z++) {
+				if (level.isOpen(x, z)) {
+					castTile(context, x, z, stamp, visible);
+					sort(visible.begin(), visible.end());
+					rowChunks[x].insert(rowChunks[x].end(), visible.begin(), visible.end());
+				}
+				rowStarts[x].push_back((uint32_t)rowChunks[x].size());
+			}
+		}
+	};
+	if (jobs) jobs->parallelFor(sizeX, 1, castRows);
+	else castRows(0, sizeX);
+
+	//Tiles that see the same chunks share a list, list 0 is empty
+	tileSet = vector<uint32_t>((size_t)sizeX * sizeZ, 0);
+	setStart = { 0, 0 };
+	unordered_map<uint64_t, vector<uint32_t>> setsByHash;
+	for (int x = 0; x < sizeX; x++) {
+		for (int z = 0; z < sizeZ; z++) {
+			const uint32_t* list = rowChunks[x].data() + rowStarts[x][z];
+			uint32_t count = rowStarts[x][z + 1] - rowStarts[x][z];
+			if (count == 0) continue;
+
+			uint64_t hash = hashBytes(list, count * sizeof(uint32_t));
+
+			vector<uint32_t>& candidates = setsByHash[hash];
+			uint32_t found = 0;
+			for (uint32_t set : candidates) {
+				if (setStart[set + 1] - setStart[set] == count && equal(list, list + count, chunks.begin() + setStart[set])) {
+					found = set;
+					break;
+				}
+			}
+			if (found == 0) {
+				found = (uint32_t)setStart.size() - 1;
+				chunks.insert(chunks.end(), list, list + count);
+				setStart.push_back((uint32_t)chunks.size());
+				candidates.push_back(found);
+			}
+			tileSet[(size_t)x * sizeZ + z] = found;
+		}
+		vector<uint32_t>().swap(rowChunks[x]);
+	}
+}
+
+/// <summary>
+/// Fingerprint of a level's walls, a cache only fits the level it was built for
+/// </summary>
+uint64_t VisibilitySet::hashLevel(LevelView level) {
+	return hashBytes(level.tiles, (size_t)level.sizeX * level.sizeZ);
+}
+
+/// <summary>
+/// Writes the sets to a cache file
+/// </summary>
+/// <param name="path">File to write</param>
+/// <returns>true if the file was written</returns>
+bool VisibilitySet::save(const string& path) const {
+	ofstream file(path, ios::binary);
+	if (!file) {
+		cout << "Unable to write visibility cache " << path << endl;
+		return false;
+	}
+
+	CacheHeader header = { cacheMagic, sizeX, sizeZ, chunkSize, maxDistance, 0, levelHash, tileSet.size(), setStart.size(), chunks.size() };
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)tileSet.data(), tileSet.size() * sizeof(uint32_t));
+	file.write((const char*)setStart.data(), setStart.size() * sizeof(uint32_t));
+	file.write((const char*)chunks.data(), chunks.size() * sizeof(uint32_t));
+	return (bool)file;
+}
+
+/// <summary>
+/// Reads the sets from a cache file, if it was built for this level, chunk size and view distance
+/// </summary>
+/// <param name="path">File to read</param>
+/// <param name="level">Level the sets are for</param>
+/// <param name="_chunkSize">Chunk size the sets are for</param>
+/// <param name="_maxDistance">View distance the sets are for</param>
+/// <returns>false if there is no usable or no intact cache, the sets are left unchanged then</returns>
+bool VisibilitySet::load(const string& path, LevelView level, int _chunkSize, float _maxDistance) {
+	ifstream file(path, ios::binary);
+	CacheHeader header;
+	if (!file || !file.read((char*)&header, sizeof(header))) return false;
+
+	size_t tiles = (size_t)level.sizeX * level.sizeZ;
+	if (header.magic != cacheMagic || header.sizeX != level.sizeX || header.sizeZ != level.sizeZ ||
+		header.chunkSize != _chunkSize || header.maxDistance != _maxDistance ||
+		header.tileCount != tiles || header.setStartCount < 2 || header.chunkCount > UINT32_MAX ||
+		header.levelHash != hashLevel(level)) {
+		return false;
+	}
+
+	vector<uint32_t> newTileSet(header.tileCount), newSetStart(header.setStartCount), newChunks(header.chunkCount);
+	file.read((char*)newTileSet.data(), newTileSet.size() * sizeof(uint32_t));
+	file.read((char*)newSetStart.data(), newSetStart.size() * sizeof(uint32_t));
+	file.read((char*)newChunks.data(), newChunks.size() * sizeof(uint32_t));
+	if (!file || newSetStart.front() != 0 || newSetStart.back() != newChunks.size()) return false;
+
+	//A damaged file must not hand negative counts or chunks outside the level to the culling
+	for (size_t i = 1; i < newSetStart.size(); i++) {
+		if (newSetStart[i] < newSetStart[i - 1]) return false;
+	}
+	uint32_t chunkTotal = (uint32_t)(max(1, (level.sizeX + _chunkSize - 1) / _chunkSize) * max(1, (level.sizeZ + _chunkSize - 1) / _chunkSize));
+	for (uint32_t chunk : newChunks) {
+		if (chunk >= chunkTotal) return false;
+	}
+	for (uint32_t set : newTileSet) {
+		if (set + 1 >= newSetStart.size()) return false;
+	}
+
+	sizeX = level.sizeX;
+	sizeZ = level.sizeZ;
+	chunkSize = _chunkSize;
+	maxDistance = header.maxDistance;
+	levelHash = header.levelHash;
+	tileSet.swap(newTileSet);
+	setStart.swap(newSetStart);
+	chunks.swap(newChunks);
+	return true;
+}
@@ -0,0 +1,53 @@
+#ifndef VisibilitySet_header
+#define VisibilitySet_header
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "levelGrid.h"
+#include "jobSystem.h"
+
+using namespace std;
+
+/// <summary>
+/// Potentially visible set of every walkable tile: the chunks (see ChunkCulling) that can be seen
+/// from anywhere on the tile. Found once per level by shadow casting through the grid, walls block
+/// the view completely since they are higher than the camera. Tiles that see the same chunks share
+/// one list, so long corridors cost a single list.
+/// </summary>
+class VisibilitySet {
+private:
+	int sizeX = 0;
+	int sizeZ = 0;
+	int chunkSize = 16;
+	float maxDistance = 0;
+	uint64_t levelHash = 0;
+	vector<uint32_t> tileSet;   // list of every tile, walls use the empty list 0
+	vector<uint32_t> setStart;  // first chunk of every list in chunks, plus the total at the end
+	vector<uint32_t> chunks;    // chunk indices of all lists, sorted within each list
+
+public:
+	VisibilitySet() = default;
+	VisibilitySet(LevelView level, int _chunkSize, float _maxDistance, JobSystem* jobs = nullptr);
+
+	bool save(const string& path) const;
+	bool load(const string& path, LevelView level, int _chunkSize, float _maxDistance);
+
+	static uint64_t hashLevel(LevelView level);
+
+	/// <summary>
+	/// Chunks visible from a tile, none for walls and tiles outside the level
+	/// </summary>
+	const uint32_t* getChunks(int x, int z, int& count) const {
+		count = 0;
+		if (x < 0 || z < 0 || x >= sizeX || z >= sizeZ) return nullptr;
+		uint32_t set = tileSet[(size_t)x * sizeZ + z];
+		count = (int)(setStart[set + 1] - setStart[set]);
+		return chunks.data() + setStart[set];
+	}
+
+	int getSetCount() const { return (int)setStart.size() - 1; }
+	size_t getMemoryUsage() const { return (tileSet.size() + setStart.size() + chunks.size()) * sizeof(uint32_t); }
+};
+
+#endif
@@ -0,0 +1,127 @@
+#include "wallMesh.h"
+#include "junctionGraph.h"
+
+#include <algorithm>
+
+//Side faces of a wall segment centered on its tile, in direction order (see dirsX/dirsZ).
+//Top and bottom faces are left out as they will never be seen anyways.
+static const float wallFaces[4][6][WallMesh::floatsPerVertex] = {
+	{ // east, +z
+		{ -0.5f, -0.5f,  0.5f,  0.0f, 0.0f, 0.0f,  0.0f,  1.0f },
+		{  0.5f, -0.5f,  0.5f,  1.0f, 0.0f, 0.0f,  0.0f,  1.0f },
+		{  0.5f,  0.5f,  0.5f,  1.0f, 1.0f, 0.0f,  0.0f,  1.0f },
+		{  0.5f,  0.5f,  0.5f,  1.0f, 1.0f, 0.0f,  0.0f,  1.0f },
+		{ -0.5f,  0.5f,  0.5f,  0.0f, 1.0f, 0.0f,  0.0f,  1.0f },
+		{ -0.5f, -0.5f,  0.5f,  0.0f, 0.0f, 0.0f,  0.0f,  1.0f },
+	},
+	{ // west, -z
+		{ -0.5f, -0.5f, -0.5f,  0.0f, 0.0f, 0.0f,  0.0f, -1.0f },
+		{  0.5f, -0.5f, -0.5f,  1.0f, 0.0f, 0.0f,  0.0f, -1.0f },
+		{  0.5f,  0.5f, -0.5f,  1.0f, 1.0f, 0.0f,  0.0f, -1.0f },
+		{  0.5f,  0.5f, -0.5f,  1.0f, 1.0f, 0.0f,  0.0f, -1.0f },
+		{ -0.5f,  0.5f, -0.5f,  0.0f, 1.0f, 0.0f,  0.0f, -1.0f },
+		{ -0.5f, -0.5f, -0.5f,  0.0f, 0.0f, 0.0f,  0.0f, -1.0f },
+	},
+	{ // south, +x
+		{  0.5f,  0.5f,  0.5f,  1.0f, 0.0f, 1.0f,  0.0f,  0.0f },
+		{  0.5f,  0.5f, -0.5f,  1.0f, 1.0f, 1.0f,  0.0f,  0.0f },
+		{  0.5f, -0.5f, -0.5f,  0.0f, 1.0f, 1.0f,  0.0f,  0.0f },
+		{  0.5f, -0.5f, -0.5f,  0.0f, 1.0f, 1.0f,  0.0f,  0.0f },
+		{  0.5f, -0.5f,  0.5f,  0.0f, 0.0f, 1.0f,  0.0f,  0.0f },
+		{  0.5f,  0.5f,  0.5f,  1.0f, 0.0f, 1.0f,  0.0f,  0.0f },
+	},
+	{ // north, -x
+		{ -0.5f,  0.5f,  0.5f,  1.0f, 0.0f, -1.0f,  0.0f,  0.0f },
+		{ -0.5f,  0.5f, -0.5f,  1.0f, 1.0f, -1.0f,  0.0f,  0.0f },
+		{ -0.5f, -0.5f, -0.5f,  0.0f, 1.0f, -1.0f,  0.0f,  0.0f },
+		{ -0.5f, -0.5f, -0.5f,  0.0f, 1.0f, -1.0f,  0.0f,  0.0f },
+		{ -0.5f, -0.5f,  0.5f,  0.0f, 0.0f, -1.0f,  0.0f,  0.0f },
+		{ -0.5f,  0.5f,  0.5f,  1.0f, 0.0f, -1.0f,  0.0f,  0.0f },
+	},
+};
+
+//Axis a side is merged along, x for the east and west sides and z for south and north,
+//and the texture coordinate that runs along that axis with how it changes per tile
+static const int runAxis[4] = { 0, 0, 2, 2 };
+static const int runTexCoord[4] = { 3, 3, 4, 4 };
+static const float runTexStep[4] = { 1.0f, 1.0f, -1.0f, -1.0f };
+
+/// <summary>
+/// Bakes the walls of a level
+/// </summary>
+/// <param name="level">Level to build the mesh for</param>
+/// <param name="_chunkSize">Tiles along each side of a chunk, see ChunkCulling</param>
+WallMesh::WallMesh(LevelView level, int _chunkSize) {
+	chunkSize = _chunkSize;
+	int chunksX = max(1, (level.sizeX + chunkSize - 1) / chunkSize);
+	int chunksZ = max(1, (level.sizeZ + chunkSize - 1) / chunkSize);
+
+	//Walls are the tiles that are not open, a side is visible only if the tile beside it is open
+	auto visible = [&level](int x, int z, int dir) {
+		return !level.isOpen(x, z) && level.isOpen(x + dirsX[dir], z + dirsZ[dir]);
+	};
+
+	//Visible sides facing the same way next to each other lie in one plane and are merged
+	//into a single quad. Walls are one tile high, so the largest rectangle is the longest run.
+	//Runs stop at chunk borders so every chunk owns one range of the vertices.
+	for (int cx = 0; cx < chunksX; cx++) {
+		for (int cz = 0; cz < chunksZ; cz++) {
+			chunkFirst.push_back(getVertexCount());
+			int beginX = cx * chunkSize, endX = min(level.sizeX, beginX + chunkSize);
+			int beginZ = cz * chunkSize, endZ = min(level.sizeZ, beginZ + chunkSize);
+
+			for (int d = 0; d < 4; d++) {
+				bool alongX = runAxis[d] == 0;
+				int lineBegin = alongX ? beginZ : beginX, lineEnd = alongX ? endZ : endX;
+				int runBegin = alongX ? beginX : beginZ, runEnd = alongX ? endX : endZ;
+				for (int line = lineBegin; line < lineEnd; line++) {
+					int start = runBegin;
+					while (start < runEnd) {
+						int x = alongX ? start : line, z = alongX ? line : start;
+						if (!visible(x, z, d)) {
+							start++;
+							continue;
+						}
+
+						int length = 1;
+						while (start + length < runEnd &&
+							visible(alongX ? start + length : line, alongX ? line : start + length, d)) {
+							length++;
+						}
+						addRun(x, z, d, length);
+						faceCount += length;
+						start += length;
+					}
+				}
+			}
+		}
+	}
+	chunkFirst.push_back(getVertexCount());
+}
+
+/// <summary>
+/// Appends one quad covering the same side of several wall segments in a row.
+/// Texture coordinates keep counting up along the run, so the repeating texture
+/// tiles exactly as it would on the separate segments.
+/// </summary>
+/// <param name="x">x tile of the first segment</param>
+/// <param name="z">z tile of the first segment</param>
+/// <param name="dir">Side of the segments, the direction its face points in</param>
+/// <param name="length">Number of segments, following runAxis</param>
+void WallMesh::addRun(int x, int z, int dir, int length) {
+	int axis = runAxis[dir], texCoord = runTexCoord[dir];
+	float stretch = (float)(length - 1);
+	for (int v = 0; v < 6; v++) {
+		float corner[floatsPerVertex];
+		copy(wallFaces[dir][v], wallFaces[dir][v] + floatsPerVertex, corner);
+
+		//Corners on the far end move to the last segment of the run
+		if (corner[axis] > 0) {
+			corner[axis] += stretch;
+			corner[texCoord] += stretch * runTexStep[dir];
+		}
+		corner[0] += x;
+		corner[2] += z;
+		vertices.insert(vertices.end(), corner, corner + floatsPerVertex);
+	}
+}
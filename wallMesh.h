@@ -0,0 +1,40 @@
+#ifndef WallMesh_header
+#define WallMesh_header
+
+#include <vector>
+#include "levelGrid.h"
+
+using namespace std;
+
+/// <summary>
+/// All walls of a level merged into one static triangle list, baked once when the level loads.
+/// Only wall faces that border a walkable tile are kept, faces between two walls or facing
+/// out of the level can never be seen. Neighbouring faces in the same plane become one quad.
+/// Vertices are laid out like a wall segment: position (3), texture coordinate (2) and normal (3),
+/// grouped by the chunk of the level they are in so chunks can be culled.
+/// </summary>
+class WallMesh {
+private:
+	vector<float> vertices;
+	int faceCount = 0;      // visible segment sides before merging
+	int chunkSize = 16;
+	vector<int> chunkFirst; // first vertex of every chunk, plus the vertex count at the end
+
+	void addRun(int x, int z, int dir, int length);
+
+public:
+	static const int floatsPerVertex = 8;
+
+	WallMesh() = default;
+	WallMesh(LevelView level, int _chunkSize = 16);
+
+	const vector<float>& getVertices() const { return vertices; }
+	int getVertexCount() const { return (int)(vertices.size() / floatsPerVertex); }
+	int getTriangleCount() const { return getVertexCount() / 3; }
+	int getFaceCount() const { return faceCount; }
+	int getChunkSize() const { return chunkSize; }
+	int getChunkFirst(int chunk) const { return chunkFirst[chunk]; }
+	int getChunkVertexCount(int chunk) const { return chunkFirst[chunk + 1] - chunkFirst[chunk]; }
+};
+
+#endif
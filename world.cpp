@@ -0,0 +1,342 @@
+#include "world.h"
+#include "levelFile.h"
+#include "fnvHash.h"
+
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+/// <summary>
+/// World constructor
+/// </summary>
+/// <param name="_seed">Seed for everything random, the same seed replays the same game</param>
+World::World(uint64_t _seed) {
+	seed = _seed;
+}
+
+World::~World() {
+	delete player;
+}
+
+/// <summary>
+/// Loads in a level and initializes Player and Ghosts
+/// </summary>
+/// <param name="file">Level file in the text or the binary format, from the asset pack or a loose file</param>
+/// <param name="ghostCount">Number of ghosts to spawn</param>
+/// <param name="chaseFraction">Share of the ghosts that chase the player, the rest wander</param>
+/// <returns>true if the level was read</returns>
+bool World::readLevel(const Asset& file, int ghostCount, float chaseFraction) {
+	//Binary levels are read in place, text levels are parsed first
+	LevelTiles tiles;
+	if (!readLevelTiles(file.data, file.size, tiles)) {
+		cout << "\n --Level file is damaged";
+		return false;
+	}
+	int xMax = tiles.columns;
+	int yMax = tiles.rows;
+
+	//Wall occupancy for collision and ghost AI, rows run along world x
+	walls = LevelGrid(yMax, xMax);
+	pelletBits = vector<uint64_t>(((size_t)xMax * yMax + 63) / 64, 0);
+
+	// read current level
+	cout << xMax << "*" << yMax << endl;
+	for (int i = 0; i < yMax; i++) {
+		for (int j = 0; j < xMax; j++) {
+			size_t tile = (size_t)i * xMax + j;
+			switch (tiles.tiles[tile]) {
+			case levelPellet:
+				pelletBits[tile / 64] |= 1ull << (tile % 64);
+				pelletCount++;
+				break;
+			case levelWall:
+				level.push_back(glm::vec3(i, 0, j));
+				walls.setWall(i, j, true);
+				break;
+			case levelPlayer:
+				player = new Player(glm::vec3(i, 0, j));
+				break;
+			}
+		}
+	}
+
+	//All walls become one static mesh of only the faces that can be seen
+	wallMesh = WallMesh(walls.view());
+	pelletChunks = ChunkBuckets(yMax, xMax, wallMesh.getChunkSize());
+	ghostChunks = ChunkBuckets(yMax, xMax, wallMesh.getChunkSize());
+	rebuildPelletList();
+	pelletTiles = livePellets;
+	for (size_t i = 0; i < pellets.size(); i++) pelletChunks.place((uint32_t)i, pellets[i]);
+
+	//Generate ghost position
+	//Spawns use stream 0 of the world seed, ghost i decides with stream i + 1
+	Pcg32 spawnRng(seed, 0);
+	graph = JunctionGraph(walls.view());
+	flow = FlowField(walls.view());
+	ghosts = GhostSystem(walls.view(), &graph, &flow);
+	for (int i = 0; i < ghostCount; i++) {
+		//Pellets contain all walkable space in map so a random pick from pellets will give a valid location
+		glm::vec3 pos = pellets[spawnRng.nextBounded((uint32_t)pellets.size())];
+		bool chasing = (int)((i + 1) * chaseFraction) > (int)(i * chaseFraction); // spread chasers evenly
+		ghosts.addGhost((int)pos.x, (int)pos.z, Pcg32(seed, i + 1), chasing);
+	}
+	ghostPos = vector<glm::vec3>(ghosts.size(), glm::vec3(0, 0, 0));
+	ghosts.update(0.0f, ghostPos.data());
+	for (size_t i = 0; i < ghostPos.size(); i++) ghostChunks.place((uint32_t)i, ghostPos[i]);
+	prevGhostPos = ghostPos;
+	prevPlayerPos = player ? player->getPosition() : glm::vec3(0.0f);
+
+	return player != nullptr;
+}
+
+/// <summary>
+/// Lets the world update ghosts on a job system, null runs everything on the calling thread
+/// </summary>
+/// <param name="_jobs">Job system to use</param>
+void World::setJobSystem(JobSystem* _jobs) {
+	jobs = _jobs;
+}
+
+/// <summary>
+/// Advances the game by one step: pellets, ghosts and then player movement
+/// </summary>
+/// <param name="dt">Time to simulate in seconds</param>
+/// <param name="input">Keys held by the player</param>
+void World::step(float dt, const PlayerInput& input) {
+	//keep the last state around for interpolation
+	prevGhostPos = ghostPos;
+	prevPlayerPos = player->getPosition();
+
+	//pellet logic
+	eatPellets(player->getPosition());
+	if (pelletCount == 0 && !win) { //win condition
+		win = true;
+		cout << "YOU WIN!" << endl;
+	}
+
+	//chasing ghosts steer by a shared field. When the player enters a new tile the next field is
+	//built a slice per step next to the ghost update and swapped in after it, the same on any thread count
+	glm::vec3 playerPos = player->getPosition();
+	flow.moveTarget((int)floor(playerPos.x + 0.5f), (int)floor(playerPos.z + 0.5f));
+
+	//ghost logic, spread over all threads when there are enough ghosts to be worth it
+	if (jobs) {
+		JobCounter flowBuild;
+		jobs->run(flowBuild, [this]() { flow.continueBuild(); });
+		jobs->parallelFor(ghosts.size(), 2048, [&](int begin, int end) {
+			ghosts.updateRange(begin, end, dt, ghostPos.data());
+		});
+		jobs->wait(flowBuild);
+	}
+	else {
+		ghosts.update(dt, ghostPos.data()); //update ghosts Position into position-array
+		flow.continueBuild();
+	}
+	flow.finishBuild();
+	for (int i = 0; i < ghostPos.size(); i++) {
+		ghostChunks.place(i, ghostPos[i]); //only changes bucket when the ghost entered another chunk
+		if (glm::distance(ghostPos[i], player->getPosition()) < 1.0f && !gameOver) { //If current ghost within range of player, Game Over!
+			gameOver = true;
+			cout << "YOU LOSE" << endl;
+		}
+	}
+
+	//userInput
+	if (!win && !gameOver) { //if game not done
+		player->processInput(input, dt, walls);
+	}
+}
+
+/// <summary>
+/// Removes the pellet within pickup range of a position, if any
+/// </summary>
+/// <param name="position">Position of the player</param>
+void World::eatPellets(glm::vec3 position) {
+	//Pickup range is below half a tile, so only the pellet on the nearest tile can be reached
+	int x = (int)floor(position.x + 0.5f);
+	int z = (int)floor(position.z + 0.5f);
+	if (x < 0 || z < 0 || x >= walls.getSizeX() || z >= walls.getSizeZ()) return;
+
+	int tile = x * walls.getSizeZ() + z;
+	uint64_t bit = 1ull << (tile % 64);
+	if ((pelletBits[tile / 64] & bit) && glm::distance(glm::vec3(x, -0.25, z), position) < 0.5f) {
+		pelletBits[tile / 64] &= ~bit;
+		pelletCount--;
+		rebuildPelletList();
+		pelletChunks.remove((uint32_t)(lower_bound(pelletTiles.begin(), pelletTiles.end(), tile) - pelletTiles.begin()));
+	}
+}
+
+/// <summary>
+/// Collects the remaining pellets into the lists handed to the renderer
+/// </summary>
+void World::rebuildPelletList() {
+	livePellets.clear();
+	pellets.clear();
+	livePellets.reserve(pelletCount);
+	pellets.reserve(pelletCount);
+
+	for (size_t word = 0; word < pelletBits.size(); word++) {
+		uint64_t bits = pelletBits[word];
+		for (int bit = 0; bits != 0; bit++, bits >>= 1) {
+			if (bits & 1) {
+				int tile = (int)(word * 64 + bit);
+				livePellets.push_back(tile);
+				pellets.push_back(glm::vec3(tile / walls.getSizeZ(), -0.25, tile % walls.getSizeZ()));
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Sets the simulation rate and how many steps one update may run to catch up
+/// </summary>
+/// <param name="hz">Simulation steps per second</param>
+/// <param name="maxCatchUpSteps">Upper bound of steps per update, excess time is dropped</param>
+void World::setTickRate(float hz, int maxCatchUpSteps) {
+	stepTime = 1.0f / hz;
+	maxStepsPerUpdate = maxCatchUpSteps;
+	accumulator = 0.0f;
+}
+
+float World::getStepTime() const {
+	return stepTime;
+}
+
+/// <summary>
+/// Accumulates frame time and runs as many fixed steps as fit into it
+/// </summary>
+/// <param name="frameTime">Time since last frame</param>
+/// <param name="input">Keys held by the player</param>
+/// <returns>Number of steps that were run</returns>
+int World::update(float frameTime, const PlayerInput& input) {
+	accumulator += frameTime;
+
+	int steps = 0;
+	while (accumulator >= stepTime && steps < maxStepsPerUpdate) {
+		step(stepTime, input);
+		accumulator -= stepTime;
+		steps++;
+	}
+
+	//After a long hitch, drop the time we could not catch up on instead of spiralling
+	if (accumulator >= stepTime) {
+		accumulator = fmod(accumulator, stepTime);
+	}
+	return steps;
+}
+
+/// <summary>
+/// How far the current frame is between the last two simulation states
+/// </summary>
+/// <returns>Value between 0 and 1</returns>
+float World::getAlpha() const {
+	return accumulator / stepTime;
+}
+
+/// <summary>
+/// Ghost positions blended between the last two simulation states
+/// </summary>
+/// <param name="out">Receives one position per ghost</param>
+void World::getInterpolatedGhostPositions(vector<glm::vec3>& out) const {
+	float alpha = getAlpha();
+	out.resize(ghostPos.size());
+	for (int i = 0; i < ghostPos.size(); i++) {
+		out[i] = glm::mix(prevGhostPos[i], ghostPos[i], alpha);
+	}
+}
+
+/// <summary>
+/// Positions of some ghosts blended between the last two simulation states
+/// </summary>
+/// <param name="indices">Ghosts to blend, e.g. collected from the visible chunks of getGhostChunks</param>
+/// <param name="out">Receives one position per index, in the same order</param>
+void World::getInterpolatedGhostPositions(const vector<uint32_t>& indices, vector<glm::vec3>& out) const {
+	float alpha = getAlpha();
+	out.resize(indices.size());
+	for (size_t i = 0; i < indices.size(); i++) {
+		out[i] = glm::mix(prevGhostPos[indices[i]], ghostPos[indices[i]], alpha);
+	}
+}
+
+/// <summary>
+/// Positions of some pellets
+/// </summary>
+/// <param name="ids">Pellets by their index among the pellets the level started with, e.g. collected from getPelletChunks</param>
+/// <param name="out">Receives one position per id, in the same order</param>
+void World::getPelletPositions(const vector<uint32_t>& ids, vector<glm::vec3>& out) const {
+	out.resize(ids.size());
+	for (size_t i = 0; i < ids.size(); i++) {
+		int tile = pelletTiles[ids[i]];
+		out[i] = glm::vec3(tile / walls.getSizeZ(), -0.25, tile % walls.getSizeZ());
+	}
+}
+
+glm::vec3 World::getInterpolatedPlayerPosition() const {
+	return glm::mix(prevPlayerPos, player->getPosition(), getAlpha());
+}
+
+const vector<glm::vec3>& World::getWalls() const {
+	return level;
+}
+
+const WallMesh& World::getWallMesh() const {
+	return wallMesh;
+}
+
+const LevelGrid& World::getLevelGrid() const {
+	return walls;
+}
+
+const vector<glm::vec3>& World::getPellets() const {
+	return pellets;
+}
+
+const vector<int>& World::getLivePellets() const {
+	return livePellets;
+}
+
+const ChunkBuckets& World::getPelletChunks() const {
+	return pelletChunks;
+}
+
+const ChunkBuckets& World::getGhostChunks() const {
+	return ghostChunks;
+}
+
+int World::getPelletCount() const {
+	return pelletCount;
+}
+
+const vector<glm::vec3>& World::getGhostPositions() const {
+	return ghostPos;
+}
+
+Player* World::getPlayer() const {
+	return player;
+}
+
+bool World::hasWon() const {
+	return win;
+}
+
+bool World::isGameOver() const {
+	return gameOver;
+}
+
+/// <summary>
+/// Fingerprint of the simulation state, equal hashes mean a run replayed identically
+/// </summary>
+/// <returns>FNV-1a hash of ghost and player positions, pellets and game state</returns>
+uint64_t World::stateHash() const {
+	uint64_t hash = fnvOffset;
+	auto add = [&hash](const void* data, size_t size) { hash = hashBytes(data, size, hash); };
+
+	glm::vec3 playerPos = player->getPosition();
+	add(ghostPos.data(), ghostPos.size() * sizeof(glm::vec3));
+	add(&playerPos, sizeof(playerPos));
+	add(pelletBits.data(), pelletBits.size() * sizeof(uint64_t));
+	add(&win, sizeof(win));
+	add(&gameOver, sizeof(gameOver));
+	return hash;
+}
@@ -0,0 +1,93 @@
+#ifndef World_header
+#define World_header
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "glm/glm/glm.hpp"
+#include "ghost.h"
+#include "player.h"
+#include "levelGrid.h"
+#include "junctionGraph.h"
+#include "flowField.h"
+#include "jobSystem.h"
+#include "pcg32.h"
+#include "wallMesh.h"
+#include "chunkCulling.h"
+#include "assetPack.h"
+
+using namespace std;
+
+class World {
+private:
+	//World variables
+	vector<glm::vec3> level;
+	LevelGrid walls;
+	WallMesh wallMesh;      // visible wall faces, baked at load
+	JunctionGraph graph;
+	FlowField flow;
+	//Pellets: one bit per tile plus a live count, draw list rebuilt when one is eaten
+	vector<uint64_t> pelletBits;
+	int pelletCount = 0;
+	vector<int> livePellets;
+	vector<glm::vec3> pellets;
+	GhostSystem ghosts;
+	vector<glm::vec3> ghostPos;
+	//Pellets and ghosts by the chunk of the wall mesh they are in, so drawing only looks at visible chunks.
+	//A pellet is known by its index in pelletTiles, the tiles of all pellets the level started with.
+	vector<int> pelletTiles;
+	ChunkBuckets pelletChunks;
+	ChunkBuckets ghostChunks;
+	JobSystem* jobs = nullptr;
+	Player* player = nullptr;
+
+	//Game logic variables
+	uint64_t seed = 0;
+	bool win = false;
+	bool gameOver = false;
+
+	void eatPellets(glm::vec3 position);
+	void rebuildPelletList();
+
+	//Fixed step simulation: state before the latest step is kept for render interpolation
+	float stepTime = 1.0f / 60.0f;
+	int maxStepsPerUpdate = 5;
+	float accumulator = 0.0f;
+	vector<glm::vec3> prevGhostPos;
+	glm::vec3 prevPlayerPos = glm::vec3(0.0f);
+
+public:
+	World(uint64_t _seed = 0);
+	World(const World&) = delete;
+	World& operator=(const World&) = delete;
+	~World();
+
+	bool readLevel(const Asset& file, int ghostCount = 4, float chaseFraction = 0.25f);
+	void setJobSystem(JobSystem* _jobs);
+	void step(float dt, const PlayerInput& input);
+
+	void setTickRate(float hz, int maxCatchUpSteps);
+	float getStepTime() const;
+	int update(float frameTime, const PlayerInput& input);
+	float getAlpha() const;
+	void getInterpolatedGhostPositions(vector<glm::vec3>& out) const;
+	void getInterpolatedGhostPositions(const vector<uint32_t>& indices, vector<glm::vec3>& out) const;
+	void getPelletPositions(const vector<uint32_t>& ids, vector<glm::vec3>& out) const;
+	glm::vec3 getInterpolatedPlayerPosition() const;
+
+	const vector<glm::vec3>& getWalls() const;
+	const WallMesh& getWallMesh() const;
+	const LevelGrid& getLevelGrid() const;
+	const vector<glm::vec3>& getPellets() const;
+	const vector<int>& getLivePellets() const;
+	const ChunkBuckets& getPelletChunks() const;
+	const ChunkBuckets& getGhostChunks() const;
+	int getPelletCount() const;
+	const vector<glm::vec3>& getGhostPositions() const;
+	Player* getPlayer() const;
+	bool hasWon() const;
+	bool isGameOver() const;
+	uint64_t stateHash() const;
+};
+
+#endif